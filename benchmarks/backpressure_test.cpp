@@ -0,0 +1,111 @@
+/* Broadcasts small messages to thousands of slow sockets so that their backpressure builds up, then drains it all,
+ * with the segmented BackPressure and with the single string it replaced. Writing off is simulated by copying
+ * what a kernel would take per syscall (64 KB), from as many segments as one scatter-gather write takes */
+
+#include "../src/AsyncSocketData.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/* The previous BackPressure, one string erased from the front every 1/32th */
+struct StringBackPressure {
+    std::string buffer;
+    unsigned int pendingRemoval = 0;
+    void append(const char *data, size_t length) {
+        buffer.append(data, length);
+    }
+    void erase(unsigned int length) {
+        pendingRemoval += length;
+        if (pendingRemoval > (buffer.length() >> 5)) {
+            buffer.erase(0, pendingRemoval);
+            pendingRemoval = 0;
+        }
+    }
+    size_t length() {
+        return buffer.length() - pendingRemoval;
+    }
+    void clear() {
+        pendingRemoval = 0;
+        buffer.clear();
+    }
+    const char *data() {
+        return buffer.data() + pendingRemoval;
+    }
+};
+
+const size_t SOCKETS = 2000, ROUNDS = 32, MESSAGES_PER_ROUND = 32, MESSAGE_SIZE = 512, SYSCALL_SIZE = 64 * 1024;
+
+/* The kernel side of a write */
+static char kernel[SYSCALL_SIZE];
+
+/* Writes off up to limit bytes, like one syscall that may take less than offered */
+size_t writeOff(StringBackPressure &backPressure, size_t limit) {
+    size_t written = std::min(limit, backPressure.length());
+    memcpy(kernel, backPressure.data(), written);
+    if (written == backPressure.length()) {
+        backPressure.clear();
+    } else {
+        backPressure.erase((unsigned int) written);
+    }
+    return written;
+}
+
+size_t writeOff(uWS::BackPressure &backPressure, size_t limit) {
+    std::string_view segments[64];
+    size_t numSegments = backPressure.getSegments(segments, 64), written = 0;
+    for (size_t i = 0; i < numSegments && written < limit; i++) {
+        size_t length = std::min(limit - written, segments[i].length());
+        memcpy(kernel + written, segments[i].data(), length);
+        written += length;
+    }
+    backPressure.erase(written);
+    return written;
+}
+
+template <class B>
+void run(const char *name) {
+    std::vector<B> sockets(SOCKETS);
+    std::string message(MESSAGE_SIZE, 'x');
+
+    auto start = std::chrono::high_resolution_clock::now();
+    size_t appended = 0, drained = 0;
+
+    /* Each round every socket gets a burst but only takes a quarter of it, so backpressure grows */
+    for (size_t round = 0; round < ROUNDS; round++) {
+        for (B &socket : sockets) {
+            for (size_t i = 0; i < MESSAGES_PER_ROUND; i++) {
+                socket.append(message.data(), message.length());
+                appended += message.length();
+            }
+            drained += writeOff(socket, MESSAGES_PER_ROUND * MESSAGE_SIZE / 4);
+        }
+    }
+    auto filled = std::chrono::high_resolution_clock::now();
+    size_t drainedWhileFilling = drained;
+
+    /* Then they all catch up */
+    for (B &socket : sockets) {
+        while (socket.length()) {
+            drained += writeOff(socket, SYSCALL_SIZE);
+        }
+    }
+    auto stop = std::chrono::high_resolution_clock::now();
+
+    if (appended != drained) {
+        printf("Error: appended %zu but drained %zu\n", appended, drained);
+        exit(1);
+    }
+
+    printf("%s: fill %.1f ns/message, drain %lld ms (%zu MB buffered)\n", name,
+        (double) std::chrono::duration_cast<std::chrono::nanoseconds>(filled - start).count() / (SOCKETS * ROUNDS * MESSAGES_PER_ROUND),
+        (long long) std::chrono::duration_cast<std::chrono::milliseconds>(stop - filled).count(), (appended - drainedWhileFilling) >> 20);
+}
+
+int main() {
+    for (int i = 0; i < 2; i++) {
+        run<StringBackPressure>("std::string");
+        run<uWS::BackPressure>("segmented");
+    }
+}
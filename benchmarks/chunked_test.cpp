@@ -0,0 +1,55 @@
+/* Decodes 64 KB of chunked encoding made of small chunks (as streamed by gRPC-web style clients) in a tight loop,
+ * with ChunkIterator and with consumeChunks, and prints ns per chunk along with how many times data was passed on */
+
+#include "../src/ChunkedEncoding.h"
+
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+int main() {
+    const int ITERATIONS = 2000;
+
+    for (unsigned int chunkLength : {10, 100, 1000}) {
+        std::stringstream ss;
+        unsigned int chunks = 0;
+        for (; ss.tellp() < 65536; chunks++) {
+            ss << std::hex << chunkLength << "\r\n" << std::string(chunkLength, 'x') << "\r\n";
+        }
+        std::string encoded = ss.str();
+        std::vector<char> buffer(encoded.length());
+
+        for (bool batched : {false, true}) {
+            unsigned long long calls = 0, bytes = 0;
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < ITERATIONS; i++) {
+                /* Batching moves data in place so start over every time */
+                memcpy(buffer.data(), encoded.data(), encoded.length());
+                std::string_view data(buffer.data(), buffer.size());
+                unsigned int state = uWS::STATE_IS_CHUNKED;
+
+                if (batched) {
+                    uWS::consumeChunks(data, state, false, [&calls, &bytes](std::string_view chunk) {
+                        calls++;
+                        bytes += chunk.length();
+                    });
+                } else {
+                    for (auto chunk : uWS::ChunkIterator(&data, &state)) {
+                        calls++;
+                        bytes += chunk.length();
+                    }
+                }
+            }
+            auto stop = std::chrono::high_resolution_clock::now();
+
+            if (bytes != (unsigned long long) ITERATIONS * chunks * chunkLength) {
+                printf("Error: decoded %llu bytes\n", bytes);
+                return 1;
+            }
+
+            printf("%4u byte chunks, %s: %.1f ns/chunk, %llu calls per 64 KB\n", chunkLength, batched ? "consumeChunks" : "ChunkIterator", (double) std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count() / (ITERATIONS * chunks), calls / ITERATIONS);
+        }
+    }
+}
@@ -0,0 +1,185 @@
+/* This is a simple yet efficient HTTP pipelining benchmark much like WRK with its pipeline script */
+
+#include <libusockets.h>
+int SSL;
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+char request[] = "GET / HTTP/1.1\r\n"
+                 "Host: server.example.com\r\n"
+                 "User-Agent: http_pipeline_test\r\n"
+                 "Accept: */*\r\n\r\n";
+
+/* The whole batch of pipelined requests, sent in one write */
+char *pipelined_request;
+int pipelined_request_length;
+
+char *host;
+int port;
+int connections;
+int depth;
+
+int responses;
+
+/* Every response starts with this, and it holds only one 'H' */
+const char status_line[] = "HTTP/1.1 ";
+
+struct http_socket {
+    /* How far we have streamed our pipelined requests */
+    int offset;
+
+    /* How many responses of this batch are still outstanding */
+    int outstanding_responses;
+
+    /* How much of status_line we have matched so far (it may span reads) */
+    int matched;
+};
+
+/* We don't need any of these */
+void on_wakeup(struct us_loop_t *loop) {
+
+}
+
+void on_pre(struct us_loop_t *loop) {
+
+}
+
+/* This is not HTTP POST, it is merely an event emitted post loop iteration */
+void on_post(struct us_loop_t *loop) {
+
+}
+
+void send_batch(struct us_socket_t *s) {
+    struct http_socket *http_socket = (struct http_socket *) us_socket_ext(SSL, s);
+
+    http_socket->offset = us_socket_write(SSL, s, pipelined_request, pipelined_request_length, 0);
+    http_socket->outstanding_responses = depth;
+}
+
+struct us_socket_t *on_http_socket_writable(struct us_socket_t *s) {
+    struct http_socket *http_socket = (struct http_socket *) us_socket_ext(SSL, s);
+
+    /* Stream whatever is remaining of the batch */
+    http_socket->offset += us_socket_write(SSL, s, pipelined_request + http_socket->offset, pipelined_request_length - http_socket->offset, 0);
+
+    return s;
+}
+
+struct us_socket_t *on_http_socket_close(struct us_socket_t *s, int code, void *reason) {
+
+    printf("Closed!\n");
+
+    return s;
+}
+
+struct us_socket_t *on_http_socket_end(struct us_socket_t *s) {
+    return us_socket_close(SSL, s, 0, NULL);
+}
+
+struct us_socket_t *on_http_socket_data(struct us_socket_t *s, char *data, int length) {
+    struct http_socket *http_socket = (struct http_socket *) us_socket_ext(SSL, s);
+
+    /* Count responses by their status lines */
+    for (int i = 0; i < length; i++) {
+        if (data[i] == status_line[http_socket->matched]) {
+            if (++http_socket->matched == sizeof(status_line) - 1) {
+                http_socket->matched = 0;
+                http_socket->outstanding_responses--;
+                responses++;
+            }
+        } else {
+            http_socket->matched = data[i] == 'H';
+        }
+    }
+
+    /* Send the next batch once we have all responses for this one */
+    if (http_socket->outstanding_responses == 0) {
+        send_batch(s);
+    } else if (http_socket->outstanding_responses < 0) {
+        /* This should never happen */
+        printf("ERROR: outstanding responses negative!");
+        exit(0);
+    }
+
+    return s;
+}
+
+struct us_socket_t *on_http_socket_open(struct us_socket_t *s, int is_client, char *ip, int ip_length) {
+    struct http_socket *http_socket = (struct http_socket *) us_socket_ext(SSL, s);
+
+    http_socket->matched = 0;
+    send_batch(s);
+
+    /* We could wait with this until we get responses */
+    if (--connections) {
+        us_socket_context_connect(SSL, us_socket_context(SSL, s), host, port, NULL, 0, sizeof(struct http_socket));
+    } else {
+        printf("Running benchmark now...\n");
+
+        us_socket_timeout(SSL, s, LIBUS_TIMEOUT_GRANULARITY);
+    }
+
+    return s;
+}
+
+struct us_socket_t *on_http_socket_timeout(struct us_socket_t *s) {
+    /* Print current statistics */
+    printf("Req/sec: %f\n", ((float)responses) / LIBUS_TIMEOUT_GRANULARITY);
+
+    responses = 0;
+    us_socket_timeout(SSL, s, LIBUS_TIMEOUT_GRANULARITY);
+
+    return s;
+}
+
+int main(int argc, char **argv) {
+
+    /* Parse host and port */
+    if (argc != 5 && argc != 6) {
+        printf("Usage: connections host port ssl [depth]\n");
+        return 0;
+    }
+
+    port = atoi(argv[3]);
+    host = malloc(strlen(argv[2]) + 1);
+    memcpy(host, argv[2], strlen(argv[2]) + 1);
+    connections = atoi(argv[1]);
+    SSL = atoi(argv[4]);
+
+    /* Same default as the pipeline script for wrk */
+    depth = argc == 6 ? atoi(argv[5]) : 16;
+    if (depth < 1) {
+        printf("Error: depth must be at least 1\n");
+        return 0;
+    }
+
+    /* Repeat the request depth times */
+    int request_length = sizeof(request) - 1;
+    pipelined_request_length = request_length * depth;
+    pipelined_request = malloc(pipelined_request_length);
+    for (int i = 0; i < depth; i++) {
+        memcpy(pipelined_request + i * request_length, request, request_length);
+    }
+
+    /* Create the event loop */
+    struct us_loop_t *loop = us_create_loop(0, on_wakeup, on_pre, on_post, 0);
+
+    /* Create a socket context for HTTP */
+    struct us_socket_context_options_t options = {};
+    struct us_socket_context_t *http_context = us_create_socket_context(SSL, loop, 0, options);
+
+    /* Set up event handlers */
+    us_socket_context_on_open(SSL, http_context, on_http_socket_open);
+    us_socket_context_on_data(SSL, http_context, on_http_socket_data);
+    us_socket_context_on_writable(SSL, http_context, on_http_socket_writable);
+    us_socket_context_on_close(SSL, http_context, on_http_socket_close);
+    us_socket_context_on_timeout(SSL, http_context, on_http_socket_timeout);
+    us_socket_context_on_end(SSL, http_context, on_http_socket_end);
+
+    /* Start making HTTP connections */
+    us_socket_context_connect(SSL, http_context, host, port, NULL, 0, sizeof(struct http_socket));
+
+    us_loop_run(loop);
+}
@@ -0,0 +1,34 @@
+/* Streams a 1 GB file upload of random bytes through the multipart parser in 64 KB chunks (as they would
+ * arrive from onData) and prints throughput. Build with -DUWS_NO_SIMD to compare against the scalar search */
+
+#include "../src/Multipart.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+
+int main() {
+    const int CHUNKS = 16384;
+
+    std::string chunk(1 << 16, 0);
+    std::mt19937 rng(1);
+    for (char &c : chunk) {
+        c = (char) rng();
+    }
+
+    uWS::StreamingMultipartParser parser("multipart/form-data; boundary=----WebKitFormBoundary7MA4YWxkTrZu0gW");
+    parser.consume("------WebKitFormBoundary7MA4YWxkTrZu0gW\r\nContent-Disposition: form-data; name=\"file\"; filename=\"upload.bin\"\r\n\r\n", [](auto *) {}, [](std::string_view, bool) {});
+
+    size_t received = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < CHUNKS; i++) {
+        parser.consume(chunk, [](auto *) {}, [&received](std::string_view data, bool) {
+            received += data.length();
+        });
+    }
+    auto stop = std::chrono::high_resolution_clock::now();
+
+    double ms = (double) std::chrono::duration_cast<std::chrono::microseconds>(stop - start).count() / 1000;
+    printf("%zu MB in %.1f ms: %.2f GB/s\n", received >> 20, ms, (double) received / ms / 1e6);
+}
@@ -0,0 +1,53 @@
+/* Parses requests with a varying number of headers in a tight loop and prints ns per request.
+ * Build with different -DUWS_HTTP_INLINE_HEADERS to compare inline capacity against overflow cost. */
+
+#include "../src/HttpParser.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+static std::string makeRequest(unsigned int headers) {
+    std::string request = "GET /benchmark HTTP/1.1\r\nHost: localhost\r\n";
+    for (unsigned int i = 1; i < headers; i++) {
+        request += "X-Benchmark-Header-" + std::to_string(i) + ": some value\r\n";
+    }
+    return request + "\r\n";
+}
+
+int main() {
+    const int ITERATIONS = 1000000;
+
+    printf("Inline headers: %d, max headers: %d\n", UWS_HTTP_INLINE_HEADERS, UWS_HTTP_MAX_HEADERS);
+
+    for (unsigned int headers : {8, 20, 40, 70}) {
+        std::string request = makeRequest(headers);
+        std::vector<char> buffer(request.length() + uWS::MINIMUM_HTTP_POST_PADDING);
+
+        unsigned long long handled = 0;
+        uWS::HttpParser httpParser;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < ITERATIONS; i++) {
+            /* The parser writes to the buffer (lower-casing, fencing) so start over every time */
+            memcpy(buffer.data(), request.data(), request.length());
+            httpParser.consumePostPadded(buffer.data(), (unsigned int) request.length(), &handled, nullptr, [](void *s, uWS::HttpRequest *) -> void * {
+                (*(unsigned long long *) s)++;
+                return s;
+            }, [](void *user, std::string_view, bool) -> void * {
+                return user;
+            }, [](void *) -> void * {
+                return nullptr;
+            });
+        }
+        auto stop = std::chrono::high_resolution_clock::now();
+
+        if (handled != ITERATIONS) {
+            printf("Error: only handled %llu of %d requests\n", handled, ITERATIONS);
+            return 1;
+        }
+
+        printf("%u headers: %.1f ns/request\n", headers, (double) std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count() / ITERATIONS);
+    }
+}
@@ -0,0 +1,49 @@
+/* Builds and compiles REST-like route tables of growing size, one route at a time and in bulk,
+ * and prints the time it takes. Every tenant gets its own 4 routes, like thousands of domain() routers would */
+
+#include "../src/HttpRouter.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+int main() {
+    for (int tenants : {250, 2500, 12500}) {
+        std::vector<std::string> patterns;
+        for (int i = 0; i < tenants; i++) {
+            std::string base = "/tenant" + std::to_string(i) + "/api/v1/users";
+            patterns.push_back(base);
+            patterns.push_back(base + "/:id");
+            patterns.push_back(base + "/:id/orders");
+            patterns.push_back(base + "/search");
+        }
+
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            uWS::HttpRouter<int> router;
+            for (std::string &pattern : patterns) {
+                router.add({"GET"}, pattern, [](auto *) { return true; });
+            }
+            router.compile();
+            auto stop = std::chrono::high_resolution_clock::now();
+
+            printf("%zu routes, one by one: %.2f ms\n", patterns.size(), std::chrono::duration<double, std::milli>(stop - start).count());
+        }
+
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            uWS::HttpRouter<int> router;
+            std::vector<uWS::HttpRouter<int>::Route> routes;
+            routes.reserve(patterns.size());
+            for (std::string &pattern : patterns) {
+                routes.push_back({{"GET"}, pattern, [](auto *) { return true; }});
+            }
+            router.add(std::move(routes));
+            router.compile();
+            auto stop = std::chrono::high_resolution_clock::now();
+
+            printf("%zu routes, in bulk: %.2f ms\n", patterns.size(), std::chrono::duration<double, std::milli>(stop - start).count());
+        }
+    }
+}
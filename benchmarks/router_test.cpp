@@ -0,0 +1,59 @@
+/* Routes requests against a REST-like table of 800 routes in a tight loop and prints ns per route,
+ * with and without the route cache. Only the static collection URLs can be replayed from cache,
+ * the rest bind a parameter (or have a parameter sibling) and are routed as usual */
+
+#include "../src/HttpRouter.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+int main() {
+    const int ITERATIONS = 2000;
+    const char *resources[] = {"users", "orders", "products", "invoices", "carts", "reviews", "sessions", "payments", "shipments", "coupons"};
+
+    uWS::HttpRouter<int> router;
+    std::vector<std::pair<std::string, std::string>> requests, staticRequests;
+
+    /* 200 resources with 4 routes each, one of them with a parameter */
+    for (int i = 0; i < 200; i++) {
+        std::string base = "/api/v1/" + std::string(resources[i % 10]) + std::to_string(i);
+
+        router.add({"GET"}, base, [](auto *) { return true; });
+        router.add({"GET"}, base + "/:id", [](auto *) { return true; });
+        router.add({"POST"}, base + "/:id/items", [](auto *) { return true; });
+        router.add({"GET"}, base + "/search", [](auto *) { return true; });
+
+        requests.push_back({"GET", base});
+        staticRequests.push_back({"GET", base});
+        requests.push_back({"GET", base + "/42"});
+        requests.push_back({"POST", base + "/42/items"});
+        requests.push_back({"GET", base + "/search"});
+    }
+
+    /* Do not measure building the compiled tree */
+    router.compile();
+
+    for (auto *workload : {&requests, &staticRequests}) {
+        for (unsigned int cacheSize : {0, 4096}) {
+            router.setCacheSize(cacheSize);
+
+            unsigned int handled = 0;
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < ITERATIONS; i++) {
+                for (auto &[method, url] : *workload) {
+                    handled += router.route(method, url);
+                }
+            }
+            auto stop = std::chrono::high_resolution_clock::now();
+
+            if (handled != ITERATIONS * workload->size()) {
+                printf("Error: only handled %u of %zu requests\n", handled, ITERATIONS * workload->size());
+                return 1;
+            }
+
+            printf("%zu %s URLs, cache size %u: %.1f ns/route\n", workload->size(), workload == &requests ? "mixed" : "static", cacheSize, (double) std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count() / (ITERATIONS * workload->size()));
+        }
+    }
+}
@@ -0,0 +1,72 @@
+/* Looks up a corpus of small and large files the way every request would without a cache (open, fstat, read small files,
+ * format validators, close) and through StaticFiles, and prints ns per request. Small files are copied out as they
+ * would be into the cork buffer, large ones are only looked up since their body is sent with sendfile either way */
+
+#include "../src/StaticFiles.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+int main() {
+    const int SMALL_FILES = 200, LARGE_FILES = 8, ITERATIONS = 50;
+
+    char root[] = "/tmp/uwsStaticBenchXXXXXX";
+    if (!mkdtemp(root)) {
+        return 1;
+    }
+
+    /* Small files of 1 to 32 kb, large ones of 4 mb */
+    std::vector<std::string> smallUrls, largeUrls;
+    for (int i = 0; i < SMALL_FILES + LARGE_FILES; i++) {
+        bool small = i < SMALL_FILES;
+        std::string name = "/file" + std::to_string(i) + (small ? ".css" : ".bin");
+        std::ofstream(root + name, std::ios::binary) << std::string(small ? 1024 + (i * 997) % (31 * 1024) : 4 * 1024 * 1024, 'x');
+        (small ? smallUrls : largeUrls).push_back(name);
+    }
+
+    std::vector<char> corkBuffer(64 * 1024);
+    uWS::StaticFiles files(root, "", 1024, 64 * 1024, 1);
+
+    for (auto *urls : {&smallUrls, &largeUrls}) {
+        for (bool cached : {false, true}) {
+            unsigned long long bytes = 0;
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < ITERATIONS; i++) {
+                for (std::string &url : *urls) {
+                    if (cached) {
+                        std::shared_ptr<uWS::StaticFile> file = files.get(url);
+                        if (file->inMemory) {
+                            std::string_view response = file->response.data();
+                            memcpy(corkBuffer.data(), response.data(), response.length());
+                            bytes += response.length();
+                        } else {
+                            bytes += file->size;
+                        }
+                    } else {
+                        int fd = open((root + url).c_str(), O_RDONLY | O_CLOEXEC);
+                        struct stat st;
+                        fstat(fd, &st);
+                        char validators[128];
+                        snprintf(validators, sizeof(validators), "ETag: \"%jx-%jx\"\r\nContent-Length: %jd\r\n", (uintmax_t) st.st_size, (uintmax_t) st.st_mtime, (intmax_t) st.st_size);
+                        if (urls == &smallUrls) {
+                            bytes += (unsigned long long) read(fd, corkBuffer.data(), (size_t) st.st_size);
+                        } else {
+                            bytes += (unsigned long long) st.st_size;
+                        }
+                        close(fd);
+                    }
+                }
+            }
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+            printf("%s files, %s: %.1f ns/request (%llu bytes)\n", urls == &smallUrls ? "Small" : "Large",
+                cached ? "StaticFiles" : "open per request", (double) ns / (double) (ITERATIONS * (int) urls->size()), bytes);
+        }
+    }
+
+    std::string command = std::string("rm -rf ") + root;
+    return system(command.c_str());
+}
@@ -0,0 +1,85 @@
+/* Percent-decodes and normalizes URLs of varying escape density in a tight loop and prints throughput,
+ * comparing the vectorized decoder with the byte at a time loop getDecodedQueryValue used to have.
+ * Build with -DUWS_NO_SIMD to compare against the scalar kernels */
+
+#include "../src/UrlDecoder.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/* The decoding loop of getDecodedQueryValue before it used decodeUrl */
+static char *legacyDecode(char *in, char *end) {
+    unsigned int length = (unsigned int) (end - in), out = 0;
+    for (unsigned int i = 0; i < length && in[i]; i++) {
+        if (in[i] == '%') {
+            if (i + 2 >= length) {
+                return nullptr;
+            }
+
+            int hex1 = in[i + 1] - '0';
+            if (hex1 > 9) {
+                hex1 &= 223;
+                hex1 -= 7;
+            }
+
+            int hex2 = in[i + 2] - '0';
+            if (hex2 > 9) {
+                hex2 &= 223;
+                hex2 -= 7;
+            }
+
+            *((unsigned char *) &in[out]) = (unsigned char) (hex1 * 16 + hex2);
+            i += 2;
+        } else {
+            in[out] = in[i] == '+' ? ' ' : in[i];
+        }
+        out++;
+    }
+    return in + out;
+}
+
+template <typename F>
+static void measure(const char *name, const std::string &input, F &&f) {
+    const int ITERATIONS = 200000;
+    std::vector<char> buffer(input.length() + 1);
+
+    size_t checksum = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        /* Both work in place so start over every time */
+        memcpy(buffer.data(), input.data(), input.length());
+        checksum += (size_t) (f(buffer.data(), buffer.data() + input.length()) - buffer.data());
+    }
+    auto stop = std::chrono::high_resolution_clock::now();
+
+    double ns = (double) std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count() / ITERATIONS;
+    printf("%-28s %4zu bytes: %7.1f ns, %6.2f GB/s (%zu)\n", name, input.length(), ns, (double) input.length() / ns, checksum / ITERATIONS);
+}
+
+int main() {
+    std::string plain, sparse, dense, path, dotted;
+    for (int i = 0; i < 16; i++) {
+        plain += "/some/plain/path";
+        sparse += "some+value%2C+";
+        dense += "%E2%82%AC%C3%B6";
+        path += "/api/v1/users/42";
+        dotted += "/a//b/./c/../d/";
+    }
+
+    for (auto &[name, input] : {std::make_pair("plain", plain), std::make_pair("sparse", sparse), std::make_pair("dense", dense)}) {
+        measure((std::string("legacy decode, ") + name).c_str(), input, [](char *begin, char *end) {
+            return legacyDecode(begin, end);
+        });
+        measure((std::string("decodeUrl, ") + name).c_str(), input, [](char *begin, char *end) {
+            return uWS::decodeUrl(begin, end, true);
+        });
+    }
+
+    for (auto &[name, input] : {std::make_pair("normal", path), std::make_pair("dotted", dotted)}) {
+        measure((std::string("normalizeUrlPath, ") + name).c_str(), input, [](char *begin, char *end) {
+            return uWS::normalizeUrlPath(begin, end);
+        });
+    }
+}
@@ -27,6 +27,12 @@ int main(int argc, char **argv) {
         strcat(CXXFLAGS, " -DUWS_NO_ZLIB");
     }
 
+    // WITH_BROTLI=1 enables brotli compression of HTTP responses
+    if (env_is("WITH_BROTLI", "1")) {
+        strcat(CXXFLAGS, " -DUWS_WITH_BROTLI");
+        strcat(LDFLAGS, " -lbrotlienc");
+    }
+
     // WITH_PROXY enables PROXY Protocol v2 support
     if (env_is("WITH_PROXY", "1")) {
         strcat(CXXFLAGS, " -DUWS_WITH_PROXY");
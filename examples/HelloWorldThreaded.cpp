@@ -11,16 +11,21 @@ int main() {
     /* Overly simple hello world app, using multiple threads */
     std::vector<std::thread *> threads(std::thread::hardware_concurrency());
 
-    std::transform(threads.begin(), threads.end(), threads.begin(), [](std::thread */*t*/) {
-        return new std::thread([]() {
-
-            uWS::SSLApp({
-                .key_file_name = "misc/key.pem",
-                .cert_file_name = "misc/cert.pem",
-                .passphrase = "1234"
-            }).get("/*", [](auto *res, auto * /*req*/) {
-                res->end("Hello world!");
-            }).listen(3000, [](auto *listen_socket) {
+    uWS::SocketContextOptions options = {
+        .key_file_name = "misc/key.pem",
+        .cert_file_name = "misc/cert.pem",
+        .passphrase = "1234"
+    };
+
+    /* Routes are built once and shared read-only by all threads, handlers must be thread safe */
+    auto routes = uWS::SSLApp(options).get("/*", [](auto *res, auto * /*req*/) {
+        res->end("Hello world!");
+    }).shareRoutes();
+
+    std::transform(threads.begin(), threads.end(), threads.begin(), [options, routes](std::thread */*t*/) {
+        return new std::thread([options, routes]() {
+
+            uWS::SSLApp(options).routes(routes).listen(3000, [](auto *listen_socket) {
 		stdoutMutex.lock();
                 if (listen_socket) {
                     /* Note that us_listen_socket_t is castable to us_socket_t */
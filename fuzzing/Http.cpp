@@ -109,6 +109,10 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
             readBytes(httpRequest->getQuery());
             readBytes(httpRequest->getQuery("hello"));
             readBytes(httpRequest->getQuery(""));
+            for (auto [key, value] : httpRequest->getQueryParameters()) {
+                readBytes(key);
+                readBytes(value);
+            }
             //readBytes(httpRequest->getParameter(0));
 
 #ifdef UWS_WITH_PROXY
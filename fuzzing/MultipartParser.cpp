@@ -8,6 +8,33 @@
 
 #include "../src/Multipart.h"
 
+/* Streams body in chunks of given size (0 being all at once) and returns everything we saw */
+static std::string streamParts(std::string_view contentType, std::string_view body, size_t chunkSize) {
+    uWS::StreamingMultipartParser smp(contentType);
+    std::string result;
+
+    for (size_t offset = 0; offset < body.length(); offset += chunkSize) {
+        bool ok = smp.consume(body.substr(offset, chunkSize ? chunkSize : body.length()), [&result](std::pair<std::string_view, std::string_view> *headers) {
+            for (int i = 0; headers[i].first.length(); i++) {
+                result.append(headers[i].first).append(1, ':').append(headers[i].second).append(1, '\n');
+            }
+            result.append("\n");
+        }, [&result](std::string_view data, bool last) {
+            result.append(data).append(last ? "|" : "");
+        });
+
+        if (!ok) {
+            return result + "error";
+        }
+
+        if (!chunkSize) {
+            break;
+        }
+    }
+
+    return result + (smp.isDone() ? "done" : "");
+}
+
 extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
 
     if (!size) {
@@ -56,6 +83,11 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
         }
     }
 
+    /* Streaming gives the same result whichever way the body is split */
+    if (streamParts(contentType, body, 0) != streamParts(contentType, body, 1 + contentTypeLength % 7)) {
+        abort();
+    }
+
     free(mutableMemory);
     return 0;
 }
@@ -0,0 +1,48 @@
+#include "../src/UrlDecoder.h"
+
+#include <string>
+#include <string_view>
+#include <cstdlib>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+
+    /* First byte selects '+' as space */
+    if (!size) {
+        return 0;
+    }
+    bool plusAsSpace = data[0] & 1;
+    std::string modifiableInput((char *) data + 1, size - 1);
+
+    char *end = uWS::decodeUrl(modifiableInput.data(), modifiableInput.data() + modifiableInput.length(), plusAsSpace);
+    if (!end) {
+        /* Normalize the raw input instead */
+        end = modifiableInput.data() + modifiableInput.length();
+    }
+
+    /* Normalization never grows a path */
+    std::string path = "/" + std::string(modifiableInput.data(), end);
+    std::string_view normalized(path.data(), (size_t) (uWS::normalizeUrlPath(path.data(), path.data() + path.length()) - path.data()));
+    if (normalized.length() > path.length() || normalized.empty() || normalized[0] != '/') {
+        abort();
+    }
+
+    /* A normalized path has no empty or dot segments left */
+    for (std::string_view segment : {"//", "/./", "/../"}) {
+        if (normalized.find(segment) != std::string_view::npos) {
+            abort();
+        }
+    }
+    for (std::string_view suffix : {"/.", "/.."}) {
+        if (normalized.length() >= suffix.length() && normalized.substr(normalized.length() - suffix.length()) == suffix) {
+            abort();
+        }
+    }
+
+    /* And normalizing it again changes nothing */
+    std::string again(normalized);
+    if (std::string_view(again.data(), (size_t) (uWS::normalizeUrlPath(again.data(), again.data() + again.length()) - again.data())) != normalized) {
+        abort();
+    }
+
+    return 0;
+}
@@ -150,12 +150,12 @@ public:
      * app has one conceptual Topic tree) */
     bool publish(std::string_view topic, std::string_view message, OpCode opCode, bool compress = false) {
         /* Anything big bypasses corking efforts */
-        if (message.length() >= LoopData::CORK_BUFFER_SIZE) {
+        if (message.length() >= ((LoopData *) us_loop_ext((us_loop_t *) Loop::get()))->corkBufferSize) {
             return topicTree->publishBig(nullptr, topic, {message, opCode, compress}, [](Subscriber *s, TopicTreeBigMessage &message) {
                 auto *ws = (WebSocket<SSL, true, int> *) s->user;
 
                 /* Send will drain if needed */
-                ws->send(message.message, (OpCode)message.opCode, message.compress);
+                ws->send(message.message, (OpCode)message.opCode, message.compress, true, &message.frame);
             });
         } else {
             return topicTree->publish(nullptr, topic, {std::string(message), opCode, compress});
@@ -307,7 +307,7 @@ public:
                 }
 
                 /* If we ever overstep maxBackpresure, exit immediately */
-                if (WebSocket<SSL, true, int>::SendStatus::DROPPED == ws->send(message.message, (OpCode)message.opCode, message.compress)) {
+                if (WebSocket<SSL, true, int>::SendStatus::DROPPED == ws->send(message.message, (OpCode)message.opCode, message.compress, true, &message.frame)) {
                     if (needsUncork) {
                         ((AsyncSocket<SSL> *)ws)->uncork();
                         needsUncork = false;
@@ -361,10 +361,14 @@ public:
         if (behavior.compression) {
             LoopData *loopData = (LoopData *) us_loop_ext(us_socket_context_loop(SSL, webSocketContext->getSocketContext()));
 
-            /* Initialize loop's deflate inflate streams */
+            /* Initialize loop's deflate inflate streams, each on its own since HTTP compression creates the context */
             if (!loopData->zlibContext) {
                 loopData->zlibContext = new ZlibContext;
+            }
+            if (!loopData->inflationStream) {
                 loopData->inflationStream = new InflationStream(CompressOptions::DEDICATED_DECOMPRESSOR);
+            }
+            if (!loopData->deflationStream) {
                 loopData->deflationStream = new DeflationStream(CompressOptions::DEDICATED_COMPRESSOR);
             }
         }
@@ -400,26 +404,26 @@ public:
         httpContext->onHttp("GET", pattern, [webSocketContext, behavior = std::move(behavior)](auto *res, auto *req) mutable {
 
             /* If we have this header set, it's a websocket */
-            std::string_view secWebSocketKey = req->getHeader("sec-websocket-key");
+            std::string_view secWebSocketKey = req->getHeader(WellKnownHeaders::SEC_WEBSOCKET_KEY);
             if (secWebSocketKey.length() == 24) {
 
                 /* Emit upgrade handler */
                 if (behavior.upgrade) {
 
                     /* Nasty, ugly Safari 15 hack */
-                    if (hasBrokenCompression(req->getHeader("user-agent"))) {
-                        std::string_view secWebSocketExtensions = req->getHeader("sec-websocket-extensions");
+                    if (hasBrokenCompression(req->getHeader(WellKnownHeaders::USER_AGENT))) {
+                        std::string_view secWebSocketExtensions = req->getHeader(WellKnownHeaders::SEC_WEBSOCKET_EXTENSIONS);
                         memset((void *) secWebSocketExtensions.data(), ' ', secWebSocketExtensions.length());
                     }
 
                     behavior.upgrade(res, req, (struct us_socket_context_t *) webSocketContext);
                 } else {
                     /* Default handler upgrades to WebSocket */
-                    std::string_view secWebSocketProtocol = req->getHeader("sec-websocket-protocol");
-                    std::string_view secWebSocketExtensions = req->getHeader("sec-websocket-extensions");
+                    std::string_view secWebSocketProtocol = req->getHeader(WellKnownHeaders::SEC_WEBSOCKET_PROTOCOL);
+                    std::string_view secWebSocketExtensions = req->getHeader(WellKnownHeaders::SEC_WEBSOCKET_EXTENSIONS);
 
                     /* Safari 15 hack */
-                    if (hasBrokenCompression(req->getHeader("user-agent"))) {
+                    if (hasBrokenCompression(req->getHeader(WellKnownHeaders::USER_AGENT))) {
                         secWebSocketExtensions = "";
                     }
 
@@ -435,6 +439,9 @@ public:
                 req->setYield(true);
             }
         }, true);
+
+        /* This route upgrades into our webSocketContext, which only our thread may touch */
+        httpContext->getSocketContextData()->currentRouter->bindToThread();
         return std::move(*this);
     }
 
@@ -454,6 +461,25 @@ public:
         return std::move(*this);
     }
 
+    /* Moves the routes of the current router (see domain) into an immutable, compiled table that apps
+     * of other threads can route with (see routes), instead of every thread building its own.
+     * Handlers are called from all of these threads. WebSocket routes belong to this app and cannot be shared,
+     * so this returns nullptr (and keeps the routes) if there are any */
+    std::shared_ptr<const HttpRouter<typename HttpContextData<SSL>::RouterData>> shareRoutes() {
+        if (!httpContext) {
+            return nullptr;
+        }
+        return httpContext->getSocketContextData()->currentRouter->share();
+    }
+
+    /* Routes the current router (see domain) with a table made by shareRoutes, possibly of another thread */
+    TemplatedApp &&routes(std::shared_ptr<const HttpRouter<typename HttpContextData<SSL>::RouterData>> table) {
+        if (httpContext) {
+            httpContext->getSocketContextData()->currentRouter->use(std::move(table));
+        }
+        return std::move(*this);
+    }
+
     TemplatedApp &&get(std::string pattern, MoveOnlyFunction<void(HttpResponse<SSL> *, HttpRequest *)> &&handler) {
         if (httpContext) {
             httpContext->onHttp("GET", pattern, std::move(handler));
@@ -27,6 +27,11 @@
 #include <cstring>
 #include <iostream>
 
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+
 #include "libusockets.h"
 
 #include "LoopData.h"
@@ -53,26 +58,83 @@ struct AsyncSocket {
     template <bool> friend struct HttpResponse;
 
 private:
-    /* Helper, do not use directly (todo: move to uSockets or de-crazify) */
-    void throttle_helper(int toggle) {
-        /* These should be exposed by uSockets */
-        static thread_local int us_events[2] = {0, 0};
-
+    /* Polls for what pollControl decides, given what uSockets polls for now */
+    void controlPoll(int (PollControl::*decide)(int)) {
         struct us_poll_t *p = (struct us_poll_t *) this;
-        struct us_loop_t *loop = us_socket_context_loop(SSL, us_socket_context(SSL, (us_socket_t *) this));
+        int events = us_poll_events(p);
+        int decidedEvents = (getAsyncSocketData()->pollControl.*decide)(events);
+        if (decidedEvents != events) {
+            us_poll_change(p, us_socket_context_loop(SSL, us_socket_context(SSL, (us_socket_t *) this)), decidedEvents);
+        }
+    }
+
+    /* Like us_socket_write, but keeps reading stopped should the write fail */
+    int socketWrite(const char *src, int length, int msgMore) {
+        int written = us_socket_write(SSL, (us_socket_t *) this, src, length, msgMore);
+        if (written < length) {
+            controlPoll(&PollControl::afterFailedWrite);
+        }
+        return written;
+    }
+
+    /* Most segments of backpressure written per syscall */
+    static const size_t MAX_GATHERED_SEGMENTS = 64;
+
+    /* Writes off as much backpressure as we can, returns whether all of it went.
+     * More is whether the caller has more to write right after */
+    bool drainBackPressure(bool more) {
+        BackPressure &backPressure = getAsyncSocketData()->buffer;
+
+#ifndef _WIN32
+        if constexpr (!SSL) {
+            /* Gather many segments per syscall. The last segment, and whatever fails, goes through
+             * uSockets below so that it polls for writable when needed (at worst one more syscall) */
+            int fd = (int) (intptr_t) us_socket_get_native_handle(SSL, (us_socket_t *) this);
+            while (backPressure.length() > BackPressure::SEGMENT_SIZE) {
+                std::string_view segments[MAX_GATHERED_SEGMENTS];
+                struct iovec iov[MAX_GATHERED_SEGMENTS];
+                size_t numSegments = backPressure.getSegments(segments, MAX_GATHERED_SEGMENTS), gathered = 0;
+                for (size_t i = 0; i < numSegments; i++) {
+                    iov[i] = {(void *) segments[i].data(), segments[i].length()};
+                    gathered += segments[i].length();
+                }
+
+                struct msghdr msg = {};
+                msg.msg_iov = iov;
+                msg.msg_iovlen = numSegments;
+                int flags = 0;
+#ifdef MSG_NOSIGNAL
+                flags |= MSG_NOSIGNAL;
+#endif
+#ifdef MSG_MORE
+                if (more || gathered < backPressure.length()) {
+                    flags |= MSG_MORE;
+                }
+#endif
+                ssize_t written = sendmsg(fd, &msg, flags);
+                if (written <= 0) {
+                    break;
+                }
+                backPressure.erase((size_t) written);
+                if ((size_t) written < gathered) {
+                    break;
+                }
+            }
+        }
+#endif
 
-        if (toggle) {
-            /* Pause */
-            int events = us_poll_events(p);
-            if (events) {
-                us_events[getBufferedAmount() ? 1 : 0] = events;
+        while (backPressure.length()) {
+            std::string_view segment = backPressure.front();
+            int written = socketWrite(segment.data(), (int) segment.length(), more || segment.length() < backPressure.length());
+            if (written <= 0) {
+                return false;
+            }
+            backPressure.erase((size_t) written);
+            if ((size_t) written < segment.length()) {
+                return false;
             }
-            us_poll_change(p, loop, 0);
-        } else {
-            /* Resume */
-            int events = us_events[getBufferedAmount() ? 1 : 0];
-            us_poll_change(p, loop, events);
         }
+        return true;
     }
 
 protected:
@@ -101,18 +163,27 @@ protected:
         us_socket_shutdown(SSL, (us_socket_t *) this);
     }
 
-    /* Experimental pause */
+    /* Stop polling this socket, until resume */
     us_socket_t *pause() {
-        throttle_helper(1);
+        controlPoll(&PollControl::pause);
         return (us_socket_t *) this;
     }
 
-    /* Experimental resume */
+    /* Poll this socket for what it polled for before pause */
     us_socket_t *resume() {
-        throttle_helper(0);
+        controlPoll(&PollControl::resume);
         return (us_socket_t *) this;
     }
 
+    /* Stop reading, until resumeReading. Backpressure keeps draining */
+    void stopReading() {
+        controlPoll(&PollControl::stopReading);
+    }
+
+    void resumeReading() {
+        controlPoll(&PollControl::resumeReading);
+    }
+
     /* Immediately close socket */
     us_socket_t *close() {
         return us_socket_close(SSL, (us_socket_t *) this, 0, nullptr);
@@ -156,7 +227,7 @@ protected:
         LoopData *loopData = getLoopData();
         BackPressure &backPressure = getAsyncSocketData()->buffer;
         size_t existingBackpressure = backPressure.length();
-        if ((!existingBackpressure) && (isCorked() || canCork()) && (loopData->corkOffset + size < LoopData::CORK_BUFFER_SIZE)) {
+        if ((!existingBackpressure) && (isCorked() || canCork()) && (loopData->corkOffset + size < loopData->corkBufferSize)) {
             /* Cork automatically if we can */
             if (isCorked()) {
                 char *sendBuffer = loopData->corkBuffer + loopData->corkOffset;
@@ -179,19 +250,37 @@ protected:
             }
 
             /* Fallback is to use the backpressure as buffer */
-            backPressure.resize(ourCorkOffset + existingBackpressure + size);
+            char *sendBuffer = backPressure.allocate(ourCorkOffset + size);
 
             /* And copy corkbuffer in front */
-            memcpy((char *) backPressure.data() + existingBackpressure, loopData->corkBuffer, ourCorkOffset);
+            memcpy(sendBuffer, loopData->corkBuffer, ourCorkOffset);
 
-            return {(char *) backPressure.data() + ourCorkOffset + existingBackpressure, SendBufferAttribute::NEEDS_DRAIN};
+            return {sendBuffer + ourCorkOffset, SendBufferAttribute::NEEDS_DRAIN};
         }
     }
 
+    /* Writes head followed by sharedBuffer, behind anything buffered or corked. What the kernel does not take
+     * of sharedBuffer is referenced by backpressure instead of copied, so it is held until written off.
+     * Returns bytes of sharedBuffer written (anywhere) and whether we now poll for writable */
+    std::pair<int, bool> writeShared(SharedBuffer *sharedBuffer, std::string_view head = {}) {
+        LoopData *loopData = getLoopData();
+        BackPressure &backPressure = getAsyncSocketData()->buffer;
+
+        /* Corked data goes first, just like when getSendBuffer falls back to backpressure */
+        if (isCorked() && loopData->corkOffset) {
+            backPressure.append(loopData->corkBuffer, loopData->corkOffset);
+            loopData->corkOffset = 0;
+        }
+        backPressure.append(head.data(), head.length());
+        backPressure.append(sharedBuffer);
+
+        /* Draining gathers it all in one syscall for plain sockets */
+        return {(int) sharedBuffer->length(), write(nullptr, 0).second};
+    }
+
     /* Returns the user space backpressure. */
     unsigned int getBufferedAmount() {
-        /* We return the actual amount of bytes in backbuffer, including pendingRemoval */
-        return (unsigned int) getAsyncSocketData()->buffer.totalLength();
+        return (unsigned int) getAsyncSocketData()->buffer.length();
     }
 
     /* Returns the text representation of an IPv4 or IPv6 address */
@@ -243,15 +332,8 @@ protected:
 
         /* We are limited if we have a per-socket buffer */
         if (asyncSocketData->buffer.length()) {
-            /* Write off as much as we can */
-            int written = us_socket_write(SSL, (us_socket_t *) this, asyncSocketData->buffer.data(), (int) asyncSocketData->buffer.length(), /*nextLength != 0 | */length);
-
-            /* On failure return, otherwise continue down the function */
-            if ((unsigned int) written < asyncSocketData->buffer.length()) {
-
-                /* Update buffering (todo: we can do better here if we keep track of what happens to this guy later on) */
-                asyncSocketData->buffer.erase((unsigned int) written);
-
+            /* Write off as much as we can, on failure return, otherwise continue down the function */
+            if (!drainBackPressure(length != 0)) {
                 if (optionally) {
                     /* Thankfully we can exit early here */
                     return {0, true};
@@ -264,13 +346,12 @@ protected:
             }
 
             /* At this point we simply have no buffer and can continue as normal */
-            asyncSocketData->buffer.clear();
         }
 
         if (length) {
             if (loopData->corkedSocket == this) {
                 /* We are corked */
-                if (LoopData::CORK_BUFFER_SIZE - loopData->corkOffset >= (unsigned int) length) {
+                if (loopData->corkBufferSize - loopData->corkOffset >= (unsigned int) length) {
                     /* If the entire chunk fits in cork buffer */
                     memcpy(loopData->corkBuffer + loopData->corkOffset, src, (unsigned int) length);
                     loopData->corkOffset += (unsigned int) length;
@@ -279,20 +360,20 @@ protected:
                     /* Strategy differences between SSL and non-SSL regarding syscall minimizing */
                     if constexpr (SSL) {
                         /* Cork up as much as we can */
-                        unsigned int stripped = LoopData::CORK_BUFFER_SIZE - loopData->corkOffset;
+                        unsigned int stripped = loopData->corkBufferSize - loopData->corkOffset;
                         memcpy(loopData->corkBuffer + loopData->corkOffset, src, stripped);
-                        loopData->corkOffset = LoopData::CORK_BUFFER_SIZE;
+                        loopData->corkOffset = loopData->corkBufferSize;
 
                         auto [written, failed] = uncork(src + stripped, length - (int) stripped, optionally);
                         return {written + (int) stripped, failed};
                     }
 
-                    /* For non-SSL we take the penalty of two syscalls */
+                    /* For non-SSL, uncork sends the cork buffer and src in one syscall */
                     return uncork(src, length, optionally);
                 }
             } else {
                 /* We are not corked */
-                int written = us_socket_write(SSL, (us_socket_t *) this, src, length, nextLength != 0);
+                int written = socketWrite(src, length, nextLength != 0);
 
                 /* Did we fail? */
                 if (written < length) {
@@ -302,11 +383,6 @@ protected:
                     }
 
                     /* Fall back to worst possible case (should be very rare for HTTP) */
-                    /* At least we can reserve room for next chunk if we know it up front */
-                    if (nextLength) {
-                        asyncSocketData->buffer.reserve(asyncSocketData->buffer.length() + (size_t) (length - written + nextLength));
-                    }
-
                     /* Buffer this chunk */
                     asyncSocketData->buffer.append(src + written, (size_t) (length - written));
 
@@ -321,6 +397,62 @@ protected:
         return {length, false};
     }
 
+    /* Writes head followed by src, in one syscall for plain sockets. The socket must have no backpressure
+     * and must not be corked with head outside the cork buffer. Like write, what the kernel does not take
+     * of head is buffered, and so is the rest of src unless optionally. Returns bytes of src written
+     * (anywhere) and whether we now poll for writable */
+    std::pair<int, bool> writeVectored(const char *head, int headLength, const char *src, int length, bool optionally = false) {
+        if (us_socket_is_closed(SSL, (us_socket_t *) this)) {
+            return {length, false};
+        }
+
+#ifndef _WIN32
+        if constexpr (!SSL) {
+            struct iovec iov[2] = {{(void *) head, (size_t) headLength}, {(void *) src, (size_t) length}};
+            struct msghdr msg = {};
+            msg.msg_iov = iov;
+            msg.msg_iovlen = 2;
+            int flags = 0;
+#ifdef MSG_NOSIGNAL
+            flags |= MSG_NOSIGNAL;
+#endif
+            ssize_t written = sendmsg((int) (intptr_t) us_socket_get_native_handle(SSL, (us_socket_t *) this), &msg, flags);
+            if (written == (ssize_t) headLength + length) {
+                return {length, false};
+            }
+
+            /* Buffer the rest of head, and let uSockets have a go at it so that it polls for writable if need be */
+            size_t totalWritten = written > 0 ? (size_t) written : 0;
+            BackPressure &backPressure = getAsyncSocketData()->buffer;
+            if (totalWritten < (size_t) headLength) {
+                backPressure.append(head + totalWritten, (size_t) headLength - totalWritten);
+                totalWritten = (size_t) headLength;
+            }
+            int srcWritten = (int) (totalWritten - (size_t) headLength);
+
+            if (optionally) {
+                if (!drainBackPressure(true)) {
+                    return {srcWritten, true};
+                }
+                int moreWritten = socketWrite(src + srcWritten, length - srcWritten, 0);
+                srcWritten += moreWritten > 0 ? moreWritten : 0;
+                return {srcWritten, srcWritten < length};
+            }
+
+            backPressure.append(src + srcWritten, (size_t) (length - srcWritten));
+            return {length, !drainBackPressure(false)};
+        }
+#endif
+
+        /* Two writes where we have no vectored write */
+        auto [headWritten, headFailed] = write(head, headLength, false, length);
+        if (headFailed && optionally) {
+            return {0, true};
+        }
+        auto [written, failed] = write(src, length, optionally);
+        return {written, headFailed || failed};
+    }
+
     /* Uncork this socket and flush or buffer any corked and/or passed data. It is essential to remember doing this. */
     /* It does NOT count bytes written from cork buffer (they are already accounted for in the write call responsible for its corking)! */
     std::pair<int, bool> uncork(const char *src = nullptr, int length = 0, bool optionally = false) {
@@ -330,6 +462,17 @@ protected:
             loopData->corkedSocket = nullptr;
 
             if (loopData->corkOffset) {
+#ifndef _WIN32
+                /* Plain sockets send corked data and src in one syscall, behind backpressure we need two anyways */
+                if constexpr (!SSL) {
+                    if (length && !getAsyncSocketData()->buffer.length()) {
+                        unsigned int corkOffset = loopData->corkOffset;
+                        loopData->corkOffset = 0;
+                        return writeVectored(loopData->corkBuffer, (int) corkOffset, src, length, optionally);
+                    }
+                }
+#endif
+
                 /* Corked data is already accounted for via its write call */
                 auto [written, failed] = write(loopData->corkBuffer, (int) loopData->corkOffset, false, length);
                 loopData->corkOffset = 0;
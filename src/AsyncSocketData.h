@@ -18,51 +18,303 @@
 #ifndef UWS_ASYNCSOCKETDATA_H
 #define UWS_ASYNCSOCKETDATA_H
 
-#include <string>
+#include <string_view>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+/* uSockets keeps its poll event bits internal, these are the ones of its eventing backends */
+#ifndef LIBUS_SOCKET_READABLE
+#if defined(__linux__) && !defined(LIBUS_USE_LIBUV) && !defined(LIBUS_USE_GCD) && !defined(LIBUS_USE_ASIO)
+#include <sys/epoll.h>
+#define LIBUS_SOCKET_READABLE ((int) EPOLLIN)
+#define LIBUS_SOCKET_WRITABLE ((int) EPOLLOUT)
+#else
+#define LIBUS_SOCKET_READABLE 1
+#define LIBUS_SOCKET_WRITABLE 2
+#endif
+#endif
 
 namespace uWS {
 
+/* An immutable buffer that any number of backpressures can hold at once, such as one published frame.
+ * The reference count is not atomic, a SharedBuffer belongs to one loop */
+struct SharedBuffer {
+private:
+    unsigned int refCount;
+    size_t bufferLength;
+
+public:
+    /* Returns a buffer of length bytes (for the caller to fill in before sharing it) with one reference */
+    static SharedBuffer *create(size_t length) {
+        SharedBuffer *sharedBuffer = (SharedBuffer *) malloc(sizeof(SharedBuffer) + length);
+        sharedBuffer->refCount = 1;
+        sharedBuffer->bufferLength = length;
+        return sharedBuffer;
+    }
+
+    char *data() {
+        return (char *) (this + 1);
+    }
+
+    size_t length() {
+        return bufferLength;
+    }
+
+    void retain() {
+        refCount++;
+    }
+
+    void release() {
+        if (!--refCount) {
+            free(this);
+        }
+    }
+};
+
+/* Backpressure is a chain of segments, so that appending never moves what is already buffered and writing
+ * it off never moves what remains. Segments of the usual size are pooled per thread. An empty BackPressure
+ * holds no memory */
 struct BackPressure {
-    std::string buffer;
-    unsigned int pendingRemoval = 0;
-    BackPressure(BackPressure &&other) {
-        buffer = std::move(other.buffer);
-        pendingRemoval = other.pendingRemoval;
+    /* Usual size of a segment, larger ones are only made for larger contiguous allocations */
+    static const size_t SEGMENT_SIZE = 16 * 1024;
+    /* How many free segments each thread keeps around */
+    static const size_t MAX_POOLED_SEGMENTS = 1024;
+
+private:
+    struct Segment {
+        Segment *next;
+        size_t capacity, begin, end;
+        /* Segments referring to a SharedBuffer are full and hold no data of their own */
+        SharedBuffer *sharedBuffer;
+
+        char *data() {
+            return sharedBuffer ? sharedBuffer->data() : (char *) (this + 1);
+        }
+    };
+
+    struct SegmentPool {
+        Segment *head = nullptr;
+        size_t count = 0;
+
+        ~SegmentPool() {
+            while (head) {
+                Segment *next = head->next;
+                free(head);
+                head = next;
+            }
+        }
+    };
+
+    static SegmentPool &getSegmentPool() {
+        static thread_local SegmentPool segmentPool;
+        return segmentPool;
+    }
+
+    Segment *head = nullptr, *tail = nullptr;
+    size_t bufferedLength = 0;
+
+    Segment *pushSegment(size_t capacity) {
+        Segment *segment;
+        SegmentPool &segmentPool = getSegmentPool();
+        if (capacity <= SEGMENT_SIZE && segmentPool.head) {
+            segment = segmentPool.head;
+            segmentPool.head = segment->next;
+            segmentPool.count--;
+        } else {
+            capacity = capacity < SEGMENT_SIZE ? SEGMENT_SIZE : capacity;
+            segment = (Segment *) malloc(sizeof(Segment) + capacity);
+            segment->capacity = capacity;
+        }
+        segment->next = nullptr;
+        segment->begin = segment->end = 0;
+        segment->sharedBuffer = nullptr;
+        return linkSegment(segment);
+    }
+
+    Segment *linkSegment(Segment *segment) {
+        if (tail) {
+            tail->next = segment;
+        } else {
+            head = segment;
+        }
+        return tail = segment;
     }
+
+    void popSegment() {
+        Segment *segment = head;
+        head = segment->next;
+        if (!head) {
+            tail = nullptr;
+        }
+
+        SegmentPool &segmentPool = getSegmentPool();
+        if (segment->sharedBuffer) {
+            segment->sharedBuffer->release();
+            free(segment);
+        } else if (segment->capacity == SEGMENT_SIZE && segmentPool.count < MAX_POOLED_SEGMENTS) {
+            segment->next = segmentPool.head;
+            segmentPool.head = segment;
+            segmentPool.count++;
+        } else {
+            free(segment);
+        }
+    }
+
+public:
     BackPressure() = default;
+    BackPressure(BackPressure &&other) : head(other.head), tail(other.tail), bufferedLength(other.bufferedLength) {
+        other.head = other.tail = nullptr;
+        other.bufferedLength = 0;
+    }
+    BackPressure(const BackPressure &) = delete;
+    BackPressure &operator=(const BackPressure &) = delete;
+
+    ~BackPressure() {
+        clear();
+    }
+
     void append(const char *data, size_t length) {
-        buffer.append(data, length);
+        while (length) {
+            if (!tail || tail->end == tail->capacity) {
+                pushSegment(SEGMENT_SIZE);
+            }
+            size_t copied = std::min<size_t>(length, tail->capacity - tail->end);
+            memcpy(tail->data() + tail->end, data, copied);
+            tail->end += copied;
+            bufferedLength += copied;
+            data += copied;
+            length -= copied;
+        }
     }
-    void erase(unsigned int length) {
-        pendingRemoval += length;
-        /* Always erase a minimum of 1/32th the current backpressure */
-        if (pendingRemoval > (buffer.length() >> 5)) {
-            buffer.erase(0, pendingRemoval);
-            pendingRemoval = 0;
+
+    /* Appends a reference to all of sharedBuffer instead of a copy */
+    void append(SharedBuffer *sharedBuffer) {
+        if (!sharedBuffer->length()) {
+            return;
         }
+        sharedBuffer->retain();
+        Segment *segment = (Segment *) malloc(sizeof(Segment));
+        segment->next = nullptr;
+        segment->capacity = segment->end = sharedBuffer->length();
+        segment->begin = 0;
+        segment->sharedBuffer = sharedBuffer;
+        linkSegment(segment);
+        bufferedLength += sharedBuffer->length();
     }
-    size_t length() {
-        return buffer.length() - pendingRemoval;
+
+    /* Appends length contiguous bytes for the caller to fill in */
+    char *allocate(size_t length) {
+        if (!tail || tail->capacity - tail->end < length) {
+            pushSegment(length);
+        }
+        char *data = tail->data() + tail->end;
+        tail->end += length;
+        bufferedLength += length;
+        return data;
     }
-    void clear() {
-        pendingRemoval = 0;
-        buffer.clear();
+
+    /* Removes length bytes off the front */
+    void erase(size_t length) {
+        length = std::min<size_t>(length, bufferedLength);
+        bufferedLength -= length;
+        while (length) {
+            size_t erased = std::min<size_t>(length, head->end - head->begin);
+            head->begin += erased;
+            length -= erased;
+            if (head->begin == head->end) {
+                popSegment();
+            }
+        }
+        /* Data may end in an allocation that did not fit the segment before it */
+        while (head && head->begin == head->end) {
+            popSegment();
+        }
     }
-    void reserve(size_t length) {
-        buffer.reserve(length + pendingRemoval);
+
+    /* The first contiguous run of buffered data */
+    std::string_view front() {
+        if (!head) {
+            return {};
+        }
+        return {head->data() + head->begin, head->end - head->begin};
     }
-    void resize(size_t length) {
-        buffer.resize(length + pendingRemoval);
+
+    /* Fills in up to maxSegments runs of buffered data from the front, for scatter-gather writes. Returns how many */
+    size_t getSegments(std::string_view *segments, size_t maxSegments) {
+        size_t numSegments = 0;
+        for (Segment *segment = head; segment && numSegments < maxSegments; segment = segment->next) {
+            if (segment->end != segment->begin) {
+                segments[numSegments++] = {segment->data() + segment->begin, segment->end - segment->begin};
+            }
+        }
+        return numSegments;
     }
-    const char *data() {
-        return buffer.data() + pendingRemoval;
+
+    /* Constant time */
+    size_t length() {
+        return bufferedLength;
     }
     size_t size() {
         return length();
     }
-    /* The total length, incuding pending removal */
-    size_t totalLength() {
-        return buffer.length();
+
+    void clear() {
+        while (head) {
+            popSegment();
+        }
+        bufferedLength = 0;
+    }
+};
+
+/* Decides what a socket polls for on top of uSockets, which polls for writable while it has backpressure to drain
+ * and for readable and writable again whenever a write fails. We may pause polling altogether, or stop only reading
+ * (when onData cannot take more) which must never take writable away from draining. Each change takes what
+ * uSockets polls for now and returns what to poll for */
+struct PollControl {
+private:
+    int pausedEvents = 0;
+    bool isPaused = false;
+    bool isReadingStopped = false;
+
+public:
+    /* Poll for nothing, remembering what we polled for (pausing twice must not forget it) */
+    int pause(int events) {
+        if (!isPaused) {
+            pausedEvents = events;
+            isPaused = true;
+        }
+        return 0;
+    }
+
+    /* Poll for what we did before pause, keeping anything uSockets polled for meanwhile */
+    int resume(int events) {
+        if (!isPaused) {
+            return events;
+        }
+        isPaused = false;
+        return afterFailedWrite(pausedEvents | events);
+    }
+
+    /* Stop polling for readable only, paused or not */
+    int stopReading(int events) {
+        isReadingStopped = true;
+        pausedEvents &= ~LIBUS_SOCKET_READABLE;
+        return events & ~LIBUS_SOCKET_READABLE;
+    }
+
+    int resumeReading(int events) {
+        isReadingStopped = false;
+        if (isPaused) {
+            pausedEvents |= LIBUS_SOCKET_READABLE;
+            return events;
+        }
+        return events | LIBUS_SOCKET_READABLE;
+    }
+
+    /* A failed write has uSockets poll for readable again, which must wait while reading is stopped */
+    int afterFailedWrite(int events) {
+        return isReadingStopped ? events & ~LIBUS_SOCKET_READABLE : events;
     }
 };
 
@@ -73,6 +325,9 @@ struct AsyncSocketData {
     /* This will do for now */
     BackPressure buffer;
 
+    /* What we poll for on top of uSockets */
+    PollControl pollControl;
+
     /* Allow move constructing us */
     AsyncSocketData(BackPressure &&backpressure) : buffer(std::move(backpressure)) {
 
@@ -25,7 +25,9 @@
 #include <algorithm>
 #include <string_view>
 #include "MoveOnlyFunction.h"
+#include "UrlDecoder.h"
 #include <optional>
+#include <cstdint>
 
 namespace uWS {
 
@@ -190,6 +192,102 @@ namespace uWS {
         return std::nullopt;
     }
 
+    /* Parses a chunk size line of 1 - 7 hex digits directly followed by CR, returning the number of digits and setting size.
+     * Returns 0 for anything else, including chunk extensions, which is left to consumeHexNumber. Reads up to 8 bytes */
+    inline unsigned int parseChunkSizeLine(const char *data, unsigned int &size) {
+        /* Digits of one stream usually come in the same number, so this loop is well predicted */
+        unsigned int digits = 0;
+        size = 0;
+        for (int value; digits < 8 && (value = hexValue(data[digits])) >= 0; digits++) {
+            size = size * 16 + (unsigned int) value;
+        }
+        return (digits && digits <= 7 && data[digits] == '\r') ? digits : 0;
+    }
+
+    /* Like memmove, but short moves (the common case for small chunks) are done inline with overlapping loads and stores,
+     * all loads coming first */
+    inline void moveData(char *destination, const char *source, size_t length) {
+        if (length > 32) {
+            memmove(destination, source, length);
+        } else if (length >= 16) {
+            char head[16], tail[16];
+            memcpy(head, source, 16);
+            memcpy(tail, source + length - 16, 16);
+            memcpy(destination, head, 16);
+            memcpy(destination + length - 16, tail, 16);
+        } else if (length >= 8) {
+            uint64_t head, tail;
+            memcpy(&head, source, 8);
+            memcpy(&tail, source + length - 8, 8);
+            memcpy(destination, &head, 8);
+            memcpy(destination + length - 8, &tail, 8);
+        } else if (length >= 4) {
+            uint32_t head, tail;
+            memcpy(&head, source, 4);
+            memcpy(&tail, source + length - 4, 4);
+            memcpy(destination, &head, 4);
+            memcpy(destination + length - 4, &tail, 4);
+        } else if (length) {
+            char first = source[0], middle = source[length / 2], last = source[length - 1];
+            destination[0] = first;
+            destination[length / 2] = middle;
+            destination[length - 1] = last;
+        }
+    }
+
+    /* Decodes all chunks in data, like iterating a ChunkIterator, but passes data on in as few calls to handler as possible.
+     * Data of small chunks is moved together in place, over the framing in between, so data must be writable. Bigger chunks
+     * are passed on where they are. The empty last chunk is passed on by itself, just like with ChunkIterator */
+    template <typename F>
+    static void consumeChunks(std::string_view &data, unsigned int &state, bool trailer, F &&handler) {
+        /* Moving more than this costs more than calling handler an extra time */
+        const size_t MAX_MOVED_CHUNK = 256;
+
+        /* Decoded data yet to be passed on */
+        char *run = nullptr, *runEnd = nullptr;
+        auto flush = [&run, &runEnd, &handler]() {
+            if (run != runEnd) {
+                handler(std::string_view(run, (size_t) (runEnd - run)));
+            }
+            run = runEnd = nullptr;
+        };
+        auto append = [&run, &runEnd, &flush, MAX_MOVED_CHUNK](const char *chunk, size_t length) {
+            if (run && length <= MAX_MOVED_CHUNK) {
+                moveData(runEnd, chunk, length);
+            } else {
+                flush();
+                run = runEnd = (char *) chunk;
+            }
+            runEnd += length;
+        };
+
+        while (data.length()) {
+            /* Whole chunks in view, the common case, skip the state machine */
+            if (state == STATE_IS_CHUNKED && data.length() >= 8) {
+                unsigned int size, digits = parseChunkSizeLine(data.data(), size);
+                if (digits && size && data.length() >= digits + 2 + size + 2 && data[digits + 1] == '\n') {
+                    append(data.data() + digits + 2, size);
+                    data.remove_prefix(digits + 2 + size + 2);
+                    continue;
+                }
+            }
+
+            std::optional<std::string_view> chunk = getNextChunk(data, state, trailer);
+            if (!chunk.has_value()) {
+                break;
+            }
+
+            if (!chunk->length()) {
+                flush();
+                handler(*chunk);
+            } else {
+                append(chunk->data(), chunk->length());
+            }
+        }
+
+        flush();
+    }
+
     /* This is really just a wrapper for convenience */
     struct ChunkIterator {
 
@@ -0,0 +1,92 @@
+/*
+ * Authored by Alex Hultman, 2018-2023.
+ * Intellectual property of third-party.
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *     http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* This module implements flow control of request body data handed to onData. A handler may ask us
+ * to stop, after which the socket stops polling for readable (but not for writable, see PollControl).
+ * What was already read is held until resumed, which is at most the rest of one read since failed
+ * writes do not have us read again, so a slow consumer costs bounded memory */
+
+#ifndef UWS_DATAFLOW_H
+#define UWS_DATAFLOW_H
+
+#include <string>
+#include <string_view>
+
+namespace uWS {
+
+struct DataFlow {
+private:
+    std::string held;
+    bool heldFin = false;
+    bool stopped = false;
+
+public:
+    bool isStopped() {
+        return stopped;
+    }
+
+    /* Bytes held for when we resume */
+    size_t heldLength() {
+        return held.length();
+    }
+
+    /* Hands data to the handler, or holds it if we are stopped. The handler returns false to stop.
+     * Returns whether we are (still) flowing */
+    template <class F>
+    bool deliver(std::string_view data, bool fin, F &&handler) {
+        if (stopped) {
+            held.append(data.data(), data.length());
+            heldFin |= fin;
+            return false;
+        }
+
+        /* Nothing is left to stop after the last chunk */
+        stopped = !handler(data, fin) && !fin;
+        return !stopped;
+    }
+
+    /* Hands over what was held, in one piece. Returns whether we are flowing again,
+     * which is false if the handler stopped us right away */
+    template <class F>
+    bool resume(F &&handler) {
+        if (!stopped) {
+            return true;
+        }
+        stopped = false;
+
+        if (held.length() || heldFin) {
+            /* The handler may stop us again, so hand over a moved out copy */
+            std::string data = std::move(held);
+            bool fin = heldFin;
+            held.clear();
+            heldFin = false;
+            return deliver(data, fin, handler);
+        }
+        return true;
+    }
+
+    void reset() {
+        held.clear();
+        held.shrink_to_fit();
+        heldFin = false;
+        stopped = false;
+    }
+};
+
+}
+
+#endif // UWS_DATAFLOW_H
@@ -58,8 +58,15 @@ namespace uWS {
                 if (responseData->onWritable) {
                     responseData->onWritable(responseData->offset);
                 } else {
-                    int written = us_quic_stream_write(s, (char *) responseData->backpressure.data(), responseData->backpressure.length());
-                    responseData->backpressure.erase(written);
+                    /* Backpressure is segmented, write until the stream takes no more */
+                    while (responseData->backpressure.length()) {
+                        std::string_view segment = responseData->backpressure.front();
+                        int written = us_quic_stream_write(s, (char *) segment.data(), (int) segment.length());
+                        responseData->backpressure.erase((size_t) written);
+                        if ((size_t) written < segment.length()) {
+                            break;
+                        }
+                    }
 
                     if (responseData->backpressure.length() == 0) {
                         printf("wrote until end, shutting down now!\n");
@@ -136,7 +143,7 @@ namespace uWS {
             Http3ContextData *contextData = (Http3ContextData *) us_quic_socket_context_ext((us_quic_socket_context_t *) this);
 
             /* Todo: This is ugly, fix */
-            std::vector<std::string> methods;
+            std::vector<std::string_view> methods;
             if (method == "*") {
                 methods = contextData->router.upperCasedMethods; //bug! needs to be upper cased!
                 // router.upperCasedMethods;
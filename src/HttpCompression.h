@@ -0,0 +1,231 @@
+/*
+ * Authored by Alex Hultman, 2018-2023.
+ * Intellectual property of third-party.
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *     http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* This module implements Accept-Encoding negotiation and compression streams for HTTP response bodies.
+ * gzip and deflate come from zlib (unless UWS_NO_ZLIB), brotli from libbrotlienc with UWS_WITH_BROTLI.
+ * Compressed output goes to the loop's ZlibContext buffers, so it is valid until the next compression */
+
+#ifndef UWS_HTTPCOMPRESSION_H
+#define UWS_HTTPCOMPRESSION_H
+
+#include <string_view>
+#include <algorithm>
+
+#include "PerMessageDeflate.h"
+
+#ifdef UWS_WITH_BROTLI
+#include <brotli/encode.h>
+#endif
+
+namespace uWS {
+
+    /* Bits, so that sets of them can be passed around */
+    enum HttpEncoding : unsigned char {
+        ENCODING_IDENTITY = 0,
+        ENCODING_DEFLATE = 1,
+        ENCODING_GZIP = 2,
+        ENCODING_BROTLI = 4
+    };
+
+    /* What we can compress on the fly in this build */
+    static const unsigned int COMPRESSIBLE_ENCODINGS =
+#if !defined(UWS_NO_ZLIB) && !defined(UWS_MOCK_ZLIB)
+        ENCODING_DEFLATE | ENCODING_GZIP |
+#endif
+#ifdef UWS_WITH_BROTLI
+        ENCODING_BROTLI |
+#endif
+        ENCODING_IDENTITY;
+
+    /* Bodies smaller than this are not worth compressing */
+    static const size_t HTTP_COMPRESSION_MIN_SIZE = 256;
+
+    static inline std::string_view getEncodingName(HttpEncoding encoding) {
+        switch (encoding) {
+            case ENCODING_DEFLATE: return "deflate";
+            case ENCODING_GZIP: return "gzip";
+            case ENCODING_BROTLI: return "br";
+            default: return "identity";
+        }
+    }
+
+    /* Returns the supported encoding the client prefers by Accept-Encoding (RFC 9110, 12.5.3), or identity.
+     * Ties go to brotli, then gzip, then deflate */
+    static inline HttpEncoding negotiateEncoding(std::string_view acceptEncoding, unsigned int supported) {
+        /* Quality in thousandths per encoding bit, -1 if not listed */
+        int qualities[5] = {-1, -1, -1, -1, -1}, anyQuality = -1;
+
+        while (acceptEncoding.length()) {
+            size_t comma = std::min<size_t>(acceptEncoding.find(','), acceptEncoding.length());
+            std::string_view element = acceptEncoding.substr(0, comma);
+            acceptEncoding.remove_prefix(std::min<size_t>(comma + 1, acceptEncoding.length()));
+
+            size_t semicolon = std::min<size_t>(element.find(';'), element.length());
+            std::string_view coding = element.substr(0, semicolon), parameters = element.substr(semicolon);
+            while (coding.length() && (coding.front() == ' ' || coding.front() == '\t')) coding.remove_prefix(1);
+            while (coding.length() && (coding.back() == ' ' || coding.back() == '\t')) coding.remove_suffix(1);
+
+            /* Only q is defined, as "q=" followed by 0, 1 or a fraction of up to three digits */
+            int quality = 1000;
+            size_t q = parameters.find('=');
+            if (q != std::string_view::npos && q > 0 && (parameters[q - 1] | 32) == 'q') {
+                std::string_view value = parameters.substr(q + 1);
+                while (value.length() && value.front() == ' ') value.remove_prefix(1);
+                quality = (value.length() && value[0] == '1') ? 1000 : 0;
+                if (value.length() > 2 && value[0] == '0' && value[1] == '.') {
+                    for (size_t i = 2, scale = 100; i < 5 && i < value.length() && value[i] >= '0' && value[i] <= '9'; i++, scale /= 10) {
+                        quality += (value[i] - '0') * (int) scale;
+                    }
+                }
+            }
+
+            auto equals = [coding](std::string_view name) {
+                return coding.length() == name.length() && std::equal(name.begin(), name.end(), coding.begin(), [](char a, char b) {
+                    return a == (b | 32);
+                });
+            };
+            if (equals("br")) {
+                qualities[ENCODING_BROTLI] = quality;
+            } else if (equals("gzip") || equals("x-gzip")) {
+                qualities[ENCODING_GZIP] = quality;
+            } else if (equals("deflate")) {
+                qualities[ENCODING_DEFLATE] = quality;
+            } else if (coding == "*") {
+                anyQuality = quality;
+            }
+        }
+
+        HttpEncoding best = ENCODING_IDENTITY;
+        int bestQuality = 0;
+        for (HttpEncoding encoding : {ENCODING_BROTLI, ENCODING_GZIP, ENCODING_DEFLATE}) {
+            int quality = qualities[encoding] == -1 ? anyQuality : qualities[encoding];
+            if ((supported & encoding) && quality > bestQuality) {
+                best = encoding;
+                bestQuality = quality;
+            }
+        }
+        return best;
+    }
+
+/* A compression stream of one encoding, used either for whole bodies (finished and reset every time)
+ * or for a body written piece by piece (flushed every time so that clients can decode what they got) */
+#if defined(UWS_NO_ZLIB) || defined(UWS_MOCK_ZLIB)
+struct HttpCompressionStream {
+    HttpCompressionStream(HttpEncoding /*encoding*/) {
+    }
+    std::string_view compress(ZlibContext * /*zlibContext*/, const std::string_view *parts, size_t /*numParts*/, bool /*finish*/) {
+        return parts[0];
+    }
+    std::string_view compress(ZlibContext * /*zlibContext*/, std::string_view raw, bool /*finish*/) {
+        return raw;
+    }
+    void reset() {
+    }
+};
+#else
+struct HttpCompressionStream {
+    HttpEncoding encoding;
+    z_stream deflationStream = {};
+#ifdef UWS_WITH_BROTLI
+    BrotliEncoderState *brotliState = nullptr;
+#endif
+
+    HttpCompressionStream(HttpEncoding encoding) : encoding(encoding) {
+#ifdef UWS_WITH_BROTLI
+        if (encoding == ENCODING_BROTLI) {
+            brotliState = BrotliEncoderCreateInstance(nullptr, nullptr, nullptr);
+            /* Higher qualities are meant for compressing ahead of time */
+            BrotliEncoderSetParameter(brotliState, BROTLI_PARAM_QUALITY, 4);
+            return;
+        }
+#endif
+        /* gzip has its own header and trailer, "deflate" means the zlib format */
+        deflateInit2(&deflationStream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, encoding == ENCODING_GZIP ? 15 + 16 : 15, 8, Z_DEFAULT_STRATEGY);
+    }
+
+    ~HttpCompressionStream() {
+#ifdef UWS_WITH_BROTLI
+        if (brotliState) {
+            BrotliEncoderDestroyInstance(brotliState);
+            return;
+        }
+#endif
+        deflateEnd(&deflationStream);
+    }
+
+    /* Compresses the parts as one, then flushes or (if finish) ends the stream. Empty input is fine */
+    std::string_view compress(ZlibContext *zlibContext, const std::string_view *parts, size_t numParts, bool finish) {
+        zlibContext->dynamicDeflationBuffer.clear();
+        for (size_t i = 0; i < numParts || (!numParts && !i); i++) {
+            bool last = i + 1 >= numParts;
+            std::string_view raw = numParts ? parts[i] : std::string_view();
+
+#ifdef UWS_WITH_BROTLI
+            if (brotliState) {
+                const uint8_t *nextIn = (const uint8_t *) raw.data();
+                size_t availableIn = raw.length();
+                BrotliEncoderOperation operation = !last ? BROTLI_OPERATION_PROCESS : (finish ? BROTLI_OPERATION_FINISH : BROTLI_OPERATION_FLUSH);
+                do {
+                    uint8_t *nextOut = (uint8_t *) zlibContext->deflationBuffer;
+                    size_t availableOut = LARGE_BUFFER_SIZE;
+                    if (!BrotliEncoderCompressStream(brotliState, operation, &availableIn, &nextIn, &availableOut, &nextOut, nullptr)) {
+                        break;
+                    }
+                    zlibContext->dynamicDeflationBuffer.append(zlibContext->deflationBuffer, LARGE_BUFFER_SIZE - availableOut);
+                } while (availableIn || BrotliEncoderHasMoreOutput(brotliState));
+                continue;
+            }
+#endif
+
+            deflationStream.next_in = (Bytef *) raw.data();
+            deflationStream.avail_in = (unsigned int) raw.length();
+
+            /* A flush with nothing left to do gives Z_BUF_ERROR, which is harmless */
+            do {
+                deflationStream.next_out = (Bytef *) zlibContext->deflationBuffer;
+                deflationStream.avail_out = LARGE_BUFFER_SIZE;
+                ::deflate(&deflationStream, !last ? Z_NO_FLUSH : (finish ? Z_FINISH : Z_SYNC_FLUSH));
+                zlibContext->dynamicDeflationBuffer.append(zlibContext->deflationBuffer, LARGE_BUFFER_SIZE - deflationStream.avail_out);
+            } while (deflationStream.avail_out == 0);
+        }
+
+        return zlibContext->dynamicDeflationBuffer;
+    }
+
+    std::string_view compress(ZlibContext *zlibContext, std::string_view raw, bool finish) {
+        return compress(zlibContext, &raw, 1, finish);
+    }
+
+    /* Ready for another body, keeping the allocated state */
+    void reset() {
+#ifdef UWS_WITH_BROTLI
+        if (brotliState) {
+            /* Brotli has no reset */
+            BrotliEncoderDestroyInstance(brotliState);
+            brotliState = BrotliEncoderCreateInstance(nullptr, nullptr, nullptr);
+            BrotliEncoderSetParameter(brotliState, BROTLI_PARAM_QUALITY, 4);
+            return;
+        }
+#endif
+        deflateReset(&deflationStream);
+    }
+};
+#endif
+
+}
+
+#endif // UWS_HTTPCOMPRESSION_H
@@ -135,8 +135,19 @@ private:
             proxyParser = &httpResponseData->proxyParser;
 #endif
 
+            /* Select the router based on SNI (only possible for SSL). This is done once for all
+             * pipelined requests in this read, their responses then all go out in one uncork below.
+             * Note: the request handler must capture no more than two pointers to not allocate */
+            auto *selectedRouter = &httpContextData->router;
+            if constexpr (SSL) {
+                void *domainRouter = us_socket_server_name_userdata(SSL, (struct us_socket_t *) s);
+                if (domainRouter) {
+                    selectedRouter = (decltype(selectedRouter)) domainRouter;
+                }
+            }
+
             /* The return value is entirely up to us to interpret. The HttpParser only care for whether the returned value is DIFFERENT or not from passed user */
-            void *returnedSocket = httpResponseData->consumePostPadded(data, (unsigned int) length, s, proxyParser, [httpContextData](void *s, HttpRequest *httpRequest) -> void * {
+            void *returnedSocket = httpResponseData->consumePostPadded(data, (unsigned int) length, s, proxyParser, [httpContextData, selectedRouter](void *s, HttpRequest *httpRequest) -> void * {
                 /* For every request we reset the timeout and hang until user makes action */
                 /* Warning: if we are in shutdown state, resetting the timer is a security issue! */
                 us_socket_timeout(SSL, (us_socket_t *) s, 0);
@@ -145,8 +156,9 @@ private:
                 HttpResponseData<SSL> *httpResponseData = (HttpResponseData<SSL> *) us_socket_ext(SSL, (us_socket_t *) s);
                 httpResponseData->offset = 0;
 
-                /* Are we not ready for another request yet? Terminate the connection. */
-                if (httpResponseData->state & HttpResponseData<SSL>::HTTP_RESPONSE_PENDING) {
+                /* Are we not ready for another request yet? Terminate the connection.
+                 * This includes a pipelined request behind a body that we stopped reading */
+                if ((httpResponseData->state & HttpResponseData<SSL>::HTTP_RESPONSE_PENDING) || httpResponseData->dataFlow.isStopped()) {
                     us_socket_close(SSL, (us_socket_t *) s, 0, nullptr);
                     return nullptr;
                 }
@@ -155,19 +167,10 @@ private:
                 httpResponseData->state = HttpResponseData<SSL>::HTTP_RESPONSE_PENDING;
 
                 /* Mark this response as connectionClose if ancient or connection: close */
-                if (httpRequest->isAncient() || httpRequest->getHeader("connection").length() == 5) {
+                if (httpRequest->isAncient() || httpRequest->getHeader(WellKnownHeaders::CONNECTION).length() == 5) {
                     httpResponseData->state |= HttpResponseData<SSL>::HTTP_CONNECTION_CLOSE;
                 }
 
-                /* Select the router based on SNI (only possible for SSL) */
-                auto *selectedRouter = &httpContextData->router;
-                if constexpr (SSL) {
-                    void *domainRouter = us_socket_server_name_userdata(SSL, (struct us_socket_t *) s);
-                    if (domainRouter) {
-                        selectedRouter = (decltype(selectedRouter)) domainRouter;
-                    }
-                }
-
                 /* Route the method and URL */
                 selectedRouter->getUserData() = {(HttpResponse<SSL> *) s, httpRequest};
                 if (!selectedRouter->route(httpRequest->getCaseSensitiveMethod(), httpRequest->getUrl())) {
@@ -211,6 +214,14 @@ private:
                 /* We always get an empty chunk even if there is no data */
                 if (httpResponseData->inStream) {
 
+                    /* Reading is stopped, but we still get the rest of what was read. Hold it for resumeData */
+                    if (httpResponseData->dataFlow.isStopped()) {
+                        httpResponseData->dataFlow.deliver(data, fin, httpResponseData->inStream);
+                        /* In case someone resumed reading behind our back */
+                        ((AsyncSocket<SSL> *) user)->stopReading();
+                        return user;
+                    }
+
                     /* Todo: can this handle timeout for non-post as well? */
                     if (fin) {
                         /* If we just got the last chunk (or empty chunk), disable timeout */
@@ -226,7 +237,7 @@ private:
                     }
 
                     /* We might respond in the handler, so do not change timeout after this */
-                    httpResponseData->inStream(data, fin);
+                    bool flowing = httpResponseData->dataFlow.deliver(data, fin, httpResponseData->inStream);
 
                     /* Was the socket closed? */
                     if (us_socket_is_closed(SSL, (struct us_socket_t *) user)) {
@@ -238,6 +249,19 @@ private:
                         return nullptr;
                     }
 
+                    /* The handler cannot take more, so stop reading until resumeData. We only time out
+                     * while a response is still draining, just like after sending it */
+                    if (!flowing) {
+                        /* Having responded, nobody will resume us and the rest of the body can never be parsed */
+                        if (((HttpResponse<SSL> *) user)->hasResponded()) {
+                            us_socket_close(SSL, (us_socket_t *) user, 0, nullptr);
+                            return nullptr;
+                        }
+                        ((AsyncSocket<SSL> *) user)->stopReading();
+                        us_socket_timeout(SSL, (struct us_socket_t *) user, ((AsyncSocket<SSL> *) user)->getBufferedAmount() ? HTTP_IDLE_TIMEOUT_S : 0);
+                        return user;
+                    }
+
                     /* If we were given the last data chunk, reset data handler to ensure following
                      * requests on the same socket won't trigger any previously registered behavior */
                     if (fin) {
@@ -359,8 +383,13 @@ private:
                 }
             }
 
-            /* Expect another writable event, or another request within the timeout */
-            asyncSocket->timeout(HTTP_IDLE_TIMEOUT_S);
+            /* Expect another writable event, or another request within the timeout.
+             * Unless all is written while onData stopped reading, then we wait for resumeData */
+            if (httpResponseData->dataFlow.isStopped() && !asyncSocket->getBufferedAmount()) {
+                asyncSocket->timeout(0);
+            } else {
+                asyncSocket->timeout(HTTP_IDLE_TIMEOUT_S);
+            }
 
             return s;
         });
@@ -421,7 +450,7 @@ public:
         HttpContextData<SSL> *httpContextData = getSocketContextData();
 
         /* Todo: This is ugly, fix */
-        std::vector<std::string> methods;
+        std::vector<std::string_view> methods;
         if (method == "*") {
             methods = httpContextData->currentRouter->upperCasedMethods;
         } else {
@@ -442,7 +471,7 @@ public:
             user.httpRequest->setParameters(r->getParameters());
 
             /* Middleware? Automatically respond to expectations */
-            std::string_view expect = user.httpRequest->getHeader("expect");
+            std::string_view expect = user.httpRequest->getHeader(WellKnownHeaders::EXPECT);
             if (expect.length() && expect == "100-continue") {
                 user.httpResponse->writeContinue();
             }
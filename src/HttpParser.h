@@ -23,15 +23,42 @@
 #include <cstring>
 #include <algorithm>
 #include <climits>
+#include <memory>
+#include <vector>
 #include "MoveOnlyFunction.h"
 #include "ChunkedEncoding.h"
 
 #include "BloomFilter.h"
+#include "WellKnownHeaders.h"
 #include "ProxyParser.h"
 #include "QueryParser.h"
+#include "Simd.h"
 
 namespace uWS {
 
+/* Header slots per request, including the request line and the terminating entry */
+#ifndef UWS_HTTP_MAX_HEADERS
+#define UWS_HTTP_MAX_HEADERS 100
+#endif
+
+/* Requests with up to this many headers are parsed without touching the overflow arena */
+#ifndef UWS_HTTP_INLINE_HEADERS
+#define UWS_HTTP_INLINE_HEADERS 32
+#endif
+
+/* Requests with up to this many query parameters are indexed without touching the overflow arena */
+#ifndef UWS_HTTP_INLINE_QUERY_PARAMETERS
+#define UWS_HTTP_INLINE_QUERY_PARAMETERS 16
+#endif
+
+static_assert(UWS_HTTP_MAX_HEADERS <= 256, "Header indices must fit in a byte");
+static_assert(UWS_HTTP_INLINE_HEADERS >= 1, "The request line is always inline");
+
+/* Maximum size of a header block (request line and headers) arriving in multiple reads */
+#ifndef UWS_HTTP_MAX_HEADERS_SIZE
+#define UWS_HTTP_MAX_HEADERS_SIZE 4096
+#endif
+
 /* We require at least this much post padding */
 static const unsigned int MINIMUM_HTTP_POST_PADDING = 32;
 static void *FULLPTR = (void *)~(uintptr_t)0;
@@ -41,17 +68,37 @@ struct HttpRequest {
     friend struct HttpParser;
 
 private:
-    const static int MAX_HEADERS = 50;
+    const static unsigned int MAX_HEADERS = UWS_HTTP_MAX_HEADERS;
+    const static unsigned int INLINE_HEADERS = std::min<unsigned int>(UWS_HTTP_INLINE_HEADERS, UWS_HTTP_MAX_HEADERS);
+    const static unsigned int INLINE_QUERY_PARAMETERS = UWS_HTTP_INLINE_QUERY_PARAMETERS;
     struct Header {
         std::string_view key, value;
-    } headers[MAX_HEADERS];
+    };
+    /* Points to either inlineHeaders or the per-thread overflow arena */
+    Header *headers = inlineHeaders;
+    /* Left uninitialized since the parser terminates what it fills in */
+    union {
+        Header inlineHeaders[INLINE_HEADERS];
+    };
+    /* Decoded query parameters, indexed on first lookup (nullptr until then).
+     * Points to either inlineQueryParameters or the per-thread overflow arena */
+    Header *queryParameters;
+    unsigned int numQueryParameters;
+    union {
+        Header inlineQueryParameters[INLINE_QUERY_PARAMETERS];
+    };
     bool ancientHttp;
     unsigned int querySeparator;
     bool didYield;
+    /* Index into headers for every well-known header, 0 if not present */
+    unsigned char wellKnownHeaders[WellKnownHeaders::UNKNOWN];
+    /* Only holds custom headers */
     BloomFilter bf;
     std::pair<int, std::string_view *> currentParameters;
 
 public:
+    HttpRequest() {}
+
     bool isAncient() {
         return ancientHttp;
     }
@@ -95,7 +142,21 @@ public:
         didYield = yield;
     }
 
+    /* Well-known headers are looked up by a single indexed load */
+    std::string_view getHeader(WellKnownHeaders::Id header) {
+        unsigned char index = wellKnownHeaders[header];
+        if (index) {
+            return headers[index].value;
+        }
+        return std::string_view(nullptr, 0);
+    }
+
     std::string_view getHeader(std::string_view lowerCasedHeader) {
+        WellKnownHeaders::Id wellKnownHeader = WellKnownHeaders::classify(lowerCasedHeader);
+        if (wellKnownHeader != WellKnownHeaders::UNKNOWN) {
+            return getHeader(wellKnownHeader);
+        }
+
         if (bf.mightHave(lowerCasedHeader)) {
             for (Header *h = headers; (++h)->key.length(); ) {
                 if (h->key.length() == lowerCasedHeader.length() && !strncmp(h->key.data(), lowerCasedHeader.data(), lowerCasedHeader.length())) {
@@ -138,12 +199,97 @@ public:
         }
     }
 
-    /* Finds and decodes the URI component. */
-    std::string_view getQuery(std::string_view key) {
-        /* Raw querystring including initial '?' sign */
-        std::string_view queryString = std::string_view(headers->value.data() + querySeparator, headers->value.length() - querySeparator);
+private:
+    /* Decodes the whole querystring once, remembering every key and value. The request line is left as is */
+    void indexQuery() {
+        /* Rare, so shared by all requests of this thread (handled one at a time) and only ever grows */
+        thread_local std::vector<Header> overflowQueryParameters;
+        /* Decoded keys and values, shared the same way. Decoding never grows a query */
+        thread_local std::string decodedQuery;
+
+        queryParameters = inlineQueryParameters;
+        numQueryParameters = 0;
+
+        char *query = (char *) headers->value.data() + querySeparator;
+        char *end = (char *) headers->value.data() + headers->value.length();
+        if (query == end) {
+            return;
+        }
+
+        /* The request line value still holds the HTTP version after the request target */
+        if (char *space = (char *) memchr(query, ' ', (size_t) (end - query))) {
+            end = space;
+        }
+
+        if (decodedQuery.length() < (size_t) (end - query)) {
+            decodedQuery.resize((size_t) (end - query));
+        }
+
+        /* Skip the initial ? */
+        decodeQuery(query + 1, end, decodedQuery.data(), [this](std::string_view key, std::string_view value) {
+            if (numQueryParameters < INLINE_QUERY_PARAMETERS) {
+                inlineQueryParameters[numQueryParameters++] = {key, value};
+                return;
+            }
+            if (numQueryParameters == INLINE_QUERY_PARAMETERS) {
+                overflowQueryParameters.assign(inlineQueryParameters, inlineQueryParameters + INLINE_QUERY_PARAMETERS);
+            }
+            overflowQueryParameters.push_back({key, value});
+            numQueryParameters++;
+        });
+
+        if (numQueryParameters > INLINE_QUERY_PARAMETERS) {
+            queryParameters = overflowQueryParameters.data();
+        }
+    }
+
+public:
+    /* Iteration over decoded query parameters (key, value) */
+    struct QueryParameterIterator {
+        Header *ptr;
+
+        bool operator!=(const QueryParameterIterator &other) const {
+            return ptr != other.ptr;
+        }
+
+        QueryParameterIterator &operator++() {
+            ptr++;
+            return *this;
+        }
+
+        std::pair<std::string_view, std::string_view> operator*() const {
+            return {ptr->key, ptr->value};
+        }
+    };
+
+    struct QueryParameters {
+        Header *first, *last;
+
+        QueryParameterIterator begin() {
+            return {first};
+        }
 
-        return getDecodedQueryValue(key, queryString);
+        QueryParameterIterator end() {
+            return {last};
+        }
+    };
+
+    /* Every decoded query parameter in order, including duplicate keys. Valid until the next request */
+    QueryParameters getQueryParameters() {
+        if (!queryParameters) {
+            indexQuery();
+        }
+        return {queryParameters, queryParameters + numQueryParameters};
+    }
+
+    /* Finds the decoded value of the first query parameter named key, nullptr if there is none */
+    std::string_view getQuery(std::string_view key) {
+        for (auto [parameterKey, value] : getQueryParameters()) {
+            if (parameterKey == key) {
+                return value;
+            }
+        }
+        return std::string_view(nullptr, 0);
     }
 
     void setParameters(std::pair<int, std::string_view *> parameters) {
@@ -160,14 +306,104 @@ public:
 
 };
 
+/* Recycles fallback blocks per thread (every Loop runs on its own thread),
+ * so that slow clients do not cost us an allocation and reallocations per request */
+template <typename BLOCK>
+struct HttpFallbackPool {
+private:
+    /* Idle blocks above this are freed */
+    static const unsigned int MAX_IDLE_BLOCKS = 64;
+    std::vector<BLOCK *> idleBlocks;
+
+    /* Thread local objects are destroyed in reverse order of construction, parsers may outlive us */
+    static inline thread_local bool destroyed = false;
+
+    ~HttpFallbackPool() {
+        destroyed = true;
+        for (BLOCK *block : idleBlocks) {
+            delete block;
+        }
+    }
+
+    static HttpFallbackPool &get() {
+        thread_local HttpFallbackPool pool;
+        return pool;
+    }
+
+public:
+    static BLOCK *acquire() {
+        if (!destroyed) {
+            HttpFallbackPool &pool = get();
+            if (pool.idleBlocks.size()) {
+                BLOCK *block = pool.idleBlocks.back();
+                pool.idleBlocks.pop_back();
+                return block;
+            }
+        }
+        return new BLOCK;
+    }
+
+    static void release(BLOCK *block) {
+        if (!destroyed) {
+            HttpFallbackPool &pool = get();
+            if (pool.idleBlocks.size() < MAX_IDLE_BLOCKS) {
+                pool.idleBlocks.push_back(block);
+                return;
+            }
+        }
+        delete block;
+    }
+};
+
 struct HttpParser {
 
 private:
-    std::string fallback;
+    /* How far we got tokenizing a header block arriving in pieces, so that we never tokenize a line twice */
+    struct HeaderCursor {
+        /* Lines [0, lines) are tokenized into headers (MAX_HEADERS slots) */
+        HttpRequest::Header *headers;
+        unsigned int lines;
+        /* Request start (past any PROXY header) and start of the first incomplete line */
+        char *start, *next;
+    };
+
+    /* Header block spanning multiple reads, along with its tokenized lines */
+    struct FallbackBlock {
+        HttpRequest::Header headers[HttpRequest::MAX_HEADERS];
+        char data[UWS_HTTP_MAX_HEADERS_SIZE + MINIMUM_HTTP_POST_PADDING];
+    };
+
+    /* Pooled block, only held while needed */
+    FallbackBlock *fallback = nullptr;
+    unsigned int fallbackLength = 0;
+    /* Everything before this offset in fallback has been scanned for line ends */
+    unsigned int fallbackScanned = 0;
+    HeaderCursor fallbackCursor = {};
     /* This guy really has only 30 bits since we reserve two highest bits to chunked encoding parsing state */
     unsigned int remainingStreamingBytes = 0;
 
-    const size_t MAX_FALLBACK_SIZE = 1024 * 4;
+    const size_t MAX_FALLBACK_SIZE = UWS_HTTP_MAX_HEADERS_SIZE;
+
+    /* Appends to fallback, acquiring a block if we have none */
+    void appendFallback(char *data, unsigned int length) {
+        if (!fallback) {
+            fallback = HttpFallbackPool<FallbackBlock>::acquire();
+            fallbackCursor = {fallback->headers, 0, nullptr, nullptr};
+        }
+        memcpy(fallback->data + fallbackLength, data, length);
+        fallbackLength += length;
+    }
+
+    /* Returns the block to the pool */
+    void releaseFallback() {
+        if (fallback) {
+            HttpFallbackPool<FallbackBlock>::release(fallback);
+            fallback = nullptr;
+        }
+        fallbackLength = 0;
+        fallbackScanned = 0;
+        fallbackCursor = {};
+    }
 
     /* Returns UINT_MAX on error. Maximum 999999999 is allowed. */
     static unsigned int toUnsignedInteger(std::string_view str) {
@@ -198,28 +434,74 @@ private:
         ((x > 96) & (x < '{'));
     }
     
-    static void *memchr_r(const char *p, const char *end) {
-        uint64_t mask = *(uint64_t *)"\r\r\r\r\r\r\r\r";
-        if (p <= end - 8) {
-            for (; p <= end - 8; p += 8) {
-                uint64_t val = *(uint64_t *)p ^ mask;
-                if ((val + 0xfefefefefefefeffull) & (~val & 0x8080808080808080ull)) {
-                    break;
+    /* Returned by the tokenizer when we ran out of header slots */
+    static const unsigned int HEADERS_OVERFLOW = UINT_MAX;
+
+    /* Tokenizes one header block using the given scanning kernels (see Simd.h), filling headers[first, capacity).
+     * When the block is incomplete, the cursor (if any) is left at the first incomplete line */
+    template <typename Kernels>
+    static inline unsigned int tokenizeHeaders(char *postPaddedBuffer, char *end, char *start, struct HttpRequest::Header *headers, unsigned int first, unsigned int capacity, HeaderCursor *cursor) {
+        char *preliminaryKey, *preliminaryValue;
+
+        for (unsigned int i = first; i < capacity; i++) {
+            preliminaryKey = postPaddedBuffer;
+            postPaddedBuffer = Kernels::lowerCaseToken(postPaddedBuffer, end);
+            if (*postPaddedBuffer == '\r') {
+                if ((postPaddedBuffer != end) & (postPaddedBuffer[1] == '\n') & (i > 0)) {
+                    headers[i].key = std::string_view(nullptr, 0);
+                    return (unsigned int) ((postPaddedBuffer + 2) - start);
+                } else {
+                    if (cursor) {
+                        cursor->lines = i;
+                        cursor->next = preliminaryKey;
+                    }
+                    return 0;
+                }
+            } else {
+                headers[i].key = std::string_view(preliminaryKey, (size_t) (postPaddedBuffer - preliminaryKey));
+                for (postPaddedBuffer++; (*postPaddedBuffer == ':' || *(unsigned char *)postPaddedBuffer < 33) && *postPaddedBuffer != '\r'; postPaddedBuffer++);
+                preliminaryValue = postPaddedBuffer;
+                postPaddedBuffer = Kernels::findCarriageReturn(postPaddedBuffer, end);
+                if (postPaddedBuffer && postPaddedBuffer[1] == '\n') {
+                    headers[i].value = std::string_view(preliminaryValue, (size_t) (postPaddedBuffer - preliminaryValue));
+                    postPaddedBuffer += 2;
+                } else {
+                    if (cursor) {
+                        cursor->lines = i;
+                        cursor->next = preliminaryKey;
+                    }
+                    return 0;
                 }
             }
         }
+        return HEADERS_OVERFLOW;
+    }
 
-        for (; p < end; p++) {
-            if (*(unsigned char *)p == '\r') {
-                return (void *)p;
-            }
+#ifdef UWS_SIMD_AVX2
+    UWS_SIMD_AVX2_FUNCTION static unsigned int tokenizeHeadersAvx2(char *postPaddedBuffer, char *end, char *start, struct HttpRequest::Header *headers, unsigned int first, unsigned int capacity, HeaderCursor *cursor) {
+        return tokenizeHeaders<simd::Avx2>(postPaddedBuffer, end, start, headers, first, capacity, cursor);
+    }
+#endif
+
+    /* Vectorized kernels are picked at runtime if available, scalar otherwise */
+    static inline unsigned int tokenizeHeaders(char *postPaddedBuffer, char *end, char *start, struct HttpRequest::Header *headers, unsigned int first, unsigned int capacity, HeaderCursor *cursor = nullptr) {
+#ifdef UWS_SIMD_AVX2
+        if (simd::hasAvx2()) {
+            return tokenizeHeadersAvx2(postPaddedBuffer, end, start, headers, first, capacity, cursor);
         }
+#endif
+        return tokenizeHeaders<simd::Native>(postPaddedBuffer, end, start, headers, first, capacity, cursor);
+    }
 
-        return nullptr;
-     }
+    static unsigned int getHeaders(char *postPaddedBuffer, char *end, HttpRequest *req, void *reserved, HeaderCursor *cursor) {
+        /* Continue where the previous piece left off (any PROXY header is already parsed) */
+        if (cursor && cursor->lines) {
+            req->headers = cursor->headers;
+            unsigned int consumed = tokenizeHeaders(cursor->next, end, cursor->start, req->headers, cursor->lines, HttpRequest::MAX_HEADERS, cursor);
+            return consumed == HEADERS_OVERFLOW ? 0 : consumed;
+        }
 
-    static unsigned int getHeaders(char *postPaddedBuffer, char *end, struct HttpRequest::Header *headers, void *reserved) {
-        char *preliminaryKey, *preliminaryValue, *start = postPaddedBuffer;
+        char *start = postPaddedBuffer;
 
         #ifdef UWS_WITH_PROXY
             /* ProxyParser is passed as reserved parameter */
@@ -239,7 +521,6 @@ private:
         #else
             /* This one is unused */
             (void) reserved;
-            (void) end;
         #endif
 
         /* It is critical for fallback buffering logic that we only return with success
@@ -247,30 +528,40 @@ private:
          * for PROXY means we can end up succeeding, yet leaving bytes in the fallback buffer
          * which is then removed, and our counters to flip due to overflow and we end up with a crash */
 
-        for (unsigned int i = 0; i < HttpRequest::MAX_HEADERS; i++) {
-            for (preliminaryKey = postPaddedBuffer; (*postPaddedBuffer != ':') & (*(unsigned char *)postPaddedBuffer > 32); *(postPaddedBuffer++) |= 32);
-            if (*postPaddedBuffer == '\r') {
-                if ((postPaddedBuffer != end) & (postPaddedBuffer[1] == '\n') & (i > 0)) {
-                    headers->key = std::string_view(nullptr, 0);
-                    return (unsigned int) ((postPaddedBuffer + 2) - start);
-                } else {
-                    return 0;
-                }
-            } else {
-                headers->key = std::string_view(preliminaryKey, (size_t) (postPaddedBuffer - preliminaryKey));
-                for (postPaddedBuffer++; (*postPaddedBuffer == ':' || *(unsigned char *)postPaddedBuffer < 33) && *postPaddedBuffer != '\r'; postPaddedBuffer++);
-                preliminaryValue = postPaddedBuffer;
-                postPaddedBuffer = (char *) memchr_r(postPaddedBuffer, end);
-                if (postPaddedBuffer && postPaddedBuffer[1] == '\n') {
-                    headers->value = std::string_view(preliminaryValue, (size_t) (postPaddedBuffer - preliminaryValue));
-                    postPaddedBuffer += 2;
-                    headers++;
-                } else {
-                    return 0;
-                }
+        /* Header blocks arriving in pieces are tokenized straight into their fallback block */
+        if (cursor) {
+            cursor->start = start;
+            req->headers = cursor->headers;
+            unsigned int consumed = tokenizeHeaders(postPaddedBuffer, end, start, req->headers, 0, HttpRequest::MAX_HEADERS, cursor);
+            return consumed == HEADERS_OVERFLOW ? 0 : consumed;
+        }
+
+        /* Most requests fit inline. Rare ones with many headers continue in the overflow arena */
+        req->headers = req->inlineHeaders;
+        unsigned int consumed = tokenizeHeaders(postPaddedBuffer, end, start, req->headers, 0, HttpRequest::INLINE_HEADERS);
+        if (consumed == HEADERS_OVERFLOW) {
+            if (HttpRequest::INLINE_HEADERS == HttpRequest::MAX_HEADERS) {
+                /* Too many headers is treated the same as an incomplete request */
+                return 0;
+            }
+
+            /* Allocated once per thread, only if we ever see such a request. Requests never outlive their parse */
+            thread_local std::unique_ptr<HttpRequest::Header[]> overflowHeaders;
+            if (!overflowHeaders) {
+                overflowHeaders.reset(new HttpRequest::Header[HttpRequest::MAX_HEADERS]);
+            }
+            std::copy(req->inlineHeaders, req->inlineHeaders + HttpRequest::INLINE_HEADERS, overflowHeaders.get());
+            req->headers = overflowHeaders.get();
+
+            /* Resume right after the last inline header (its value is followed by CRLF) */
+            HttpRequest::Header &last = req->headers[HttpRequest::INLINE_HEADERS - 1];
+            char *resume = (char *) last.value.data() + last.value.length() + 2;
+            consumed = tokenizeHeaders(resume, end, start, req->headers, HttpRequest::INLINE_HEADERS, HttpRequest::MAX_HEADERS);
+            if (consumed == HEADERS_OVERFLOW) {
+                return 0;
             }
         }
-        return 0;
+        return consumed;
     }
 
     /* This is the only caller of getHeaders and is thus the deepest part of the parser.
@@ -278,7 +569,7 @@ private:
       * or [consumed, nullptr] for "break; I am closed or upgraded to websocket"
       * or [whatever, fullptr] for "break and close me, I am a parser error!" */
     template <int CONSUME_MINIMALLY>
-    std::pair<unsigned int, void *> fenceAndConsumePostPadded(char *data, unsigned int length, void *user, void *reserved, HttpRequest *req, MoveOnlyFunction<void *(void *, HttpRequest *)> &requestHandler, MoveOnlyFunction<void *(void *, std::string_view, bool)> &dataHandler) {
+    std::pair<unsigned int, void *> fenceAndConsumePostPadded(char *data, unsigned int length, void *user, void *reserved, HttpRequest *req, MoveOnlyFunction<void *(void *, HttpRequest *)> &requestHandler, MoveOnlyFunction<void *(void *, std::string_view, bool)> &dataHandler, HeaderCursor *cursor = nullptr) {
 
         /* How much data we CONSUMED (to throw away) */
         unsigned int consumedTotal = 0;
@@ -286,7 +577,7 @@ private:
         /* Fence one byte past end of our buffer (buffer has post padded margins) */
         data[length] = '\r';
 
-        for (unsigned int consumed; length && (consumed = getHeaders(data, data + length, req->headers, reserved)); ) {
+        for (unsigned int consumed; length && (consumed = getHeaders(data, data + length, req, reserved, cursor)); ) {
             data += consumed;
             length -= consumed;
             consumedTotal += consumed;
@@ -294,14 +585,23 @@ private:
             /* Store HTTP version (ancient 1.0 or 1.1) */
             req->ancientHttp = false;
 
-            /* Add all headers to bloom filter */
+            /* Put well-known headers in their slots and add the rest to bloom filter */
             req->bf.reset();
+            memset(req->wellKnownHeaders, 0, sizeof(req->wellKnownHeaders));
             for (HttpRequest::Header *h = req->headers; (++h)->key.length(); ) {
-                req->bf.add(h->key);
+                WellKnownHeaders::Id wellKnownHeader = WellKnownHeaders::classify(h->key);
+                if (wellKnownHeader != WellKnownHeaders::UNKNOWN) {
+                    /* First one wins, just like for custom headers */
+                    if (!req->wellKnownHeaders[wellKnownHeader]) {
+                        req->wellKnownHeaders[wellKnownHeader] = (unsigned char) (h - req->headers);
+                    }
+                } else {
+                    req->bf.add(h->key);
+                }
             }
-            
+
             /* Break if no host header (but we can have empty string which is different from nullptr) */
-            if (!req->getHeader("host").data()) {
+            if (!req->getHeader(WellKnownHeaders::HOST).data()) {
                 return {0, FULLPTR};
             }
 
@@ -310,8 +610,8 @@ private:
             * the Transfer-Encoding overrides the Content-Length. Such a message might indicate an attempt
             * to perform request smuggling (Section 11.2) or response splitting (Section 11.1) and
             * ought to be handled as an error. */
-            std::string_view transferEncodingString = req->getHeader("transfer-encoding");
-            std::string_view contentLengthString = req->getHeader("content-length");
+            std::string_view transferEncodingString = req->getHeader(WellKnownHeaders::TRANSFER_ENCODING);
+            std::string_view contentLengthString = req->getHeader(WellKnownHeaders::CONTENT_LENGTH);
             if (transferEncodingString.length() && contentLengthString.length()) {
                 /* Returning fullptr is the same as calling the errorHandler */
                 /* We could be smart and set an error in the context along with this, to indicate what 
@@ -322,6 +622,7 @@ private:
             /* Parse query */
             const char *querySeparatorPtr = (const char *) memchr(req->headers->value.data(), '?', req->headers->value.length());
             req->querySeparator = (unsigned int) ((querySeparatorPtr ? querySeparatorPtr : req->headers->value.data() + req->headers->value.length()) - req->headers->value.data());
+            req->queryParameters = nullptr;
 
             /* If returned socket is not what we put in we need
              * to break here as we either have upgraded to
@@ -360,9 +661,9 @@ private:
                 if (!CONSUME_MINIMALLY) {
                     /* Go ahead and parse it (todo: better heuristics for emitting FIN to the app level) */
                     std::string_view dataToConsume(data, length);
-                    for (auto chunk : uWS::ChunkIterator(&dataToConsume, &remainingStreamingBytes)) {
+                    uWS::consumeChunks(dataToConsume, remainingStreamingBytes, false, [&dataHandler, user](std::string_view chunk) {
                         dataHandler(user, chunk, chunk.length() == 0);
-                    }
+                    });
                     if (isParsingInvalidChunkedEncoding(remainingStreamingBytes)) {
                         return {0, FULLPTR};
                     }
@@ -401,6 +702,14 @@ private:
     }
 
 public:
+    HttpParser() = default;
+    HttpParser(const HttpParser &) = delete;
+    HttpParser &operator=(const HttpParser &) = delete;
+
+    ~HttpParser() {
+        releaseFallback();
+    }
+
     void *consumePostPadded(char *data, unsigned int length, void *user, void *reserved, MoveOnlyFunction<void *(void *, HttpRequest *)> &&requestHandler, MoveOnlyFunction<void *(void *, std::string_view, bool)> &&dataHandler, MoveOnlyFunction<void *(void *)> &&errorHandler) {
 
         /* This resets BloomFilter by construction, but later we also reset it again.
@@ -412,9 +721,9 @@ public:
             /* It's either chunked or with a content-length */
             if (isParsingChunkedEncoding(remainingStreamingBytes)) {
                 std::string_view dataToConsume(data, length);
-                for (auto chunk : uWS::ChunkIterator(&dataToConsume, &remainingStreamingBytes)) {
+                uWS::consumeChunks(dataToConsume, remainingStreamingBytes, false, [&dataHandler, user](std::string_view chunk) {
                     dataHandler(user, chunk, chunk.length() == 0);
-                }
+                });
                 if (isParsingInvalidChunkedEncoding(remainingStreamingBytes)) {
                     return FULLPTR;
                 }
@@ -441,17 +750,24 @@ public:
                 }
             }
 
-        } else if (fallback.length()) {
-            unsigned int had = (unsigned int) fallback.length();
+        } else if (fallbackLength) {
+            unsigned int had = fallbackLength;
 
-            size_t maxCopyDistance = std::min<size_t>(MAX_FALLBACK_SIZE - fallback.length(), (size_t) length);
+            unsigned int maxCopyDistance = std::min<unsigned int>((unsigned int) MAX_FALLBACK_SIZE - fallbackLength, length);
+            appendFallback(data, maxCopyDistance);
 
-            /* We don't want fallback to be short string optimized, since we want to move it */
-            fallback.reserve(fallback.length() + maxCopyDistance + std::max<unsigned int>(MINIMUM_HTTP_POST_PADDING, sizeof(std::string)));
-            fallback.append(data, maxCopyDistance);
+            /* Nothing new to tokenize until another line is complete */
+            bool hasNewLine = memchr(fallback->data + fallbackScanned, '\n', fallbackLength - fallbackScanned);
+            fallbackScanned = fallbackLength;
+            if (!hasNewLine) {
+                if (fallbackLength == MAX_FALLBACK_SIZE) {
+                    return errorHandler(user);
+                }
+                return user;
+            }
 
             // break here on break
-            std::pair<unsigned int, void *> consumed = fenceAndConsumePostPadded<true>(fallback.data(), (unsigned int) fallback.length(), user, reserved, &req, requestHandler, dataHandler);
+            std::pair<unsigned int, void *> consumed = fenceAndConsumePostPadded<true>(fallback->data, fallbackLength, user, reserved, &req, requestHandler, dataHandler, &fallbackCursor);
             if (consumed.second != user) {
                 return consumed.second;
             }
@@ -461,7 +777,7 @@ public:
                 /* This logic assumes that we consumed everything in fallback buffer.
                  * This is critically important, as we will get an integer overflow in case
                  * of "had" being larger than what we consumed, and that we would drop data */
-                fallback.clear();
+                releaseFallback();
                 data += consumed.first - had;
                 length -= consumed.first - had;
 
@@ -469,9 +785,9 @@ public:
                     /* It's either chunked or with a content-length */
                     if (isParsingChunkedEncoding(remainingStreamingBytes)) {
                         std::string_view dataToConsume(data, length);
-                        for (auto chunk : uWS::ChunkIterator(&dataToConsume, &remainingStreamingBytes)) {
+                        uWS::consumeChunks(dataToConsume, remainingStreamingBytes, false, [&dataHandler, user](std::string_view chunk) {
                             dataHandler(user, chunk, chunk.length() == 0);
-                        }
+                        });
                         if (isParsingInvalidChunkedEncoding(remainingStreamingBytes)) {
                             return FULLPTR;
                         }
@@ -499,7 +815,7 @@ public:
                 }
 
             } else {
-                if (fallback.length() == MAX_FALLBACK_SIZE) {
+                if (fallbackLength == MAX_FALLBACK_SIZE) {
                     // note: you don't really need error handler, just return something strange!
                     // we could have it return a constant pointer to denote error!
                     return errorHandler(user);
@@ -518,7 +834,9 @@ public:
 
         if (length) {
             if (length < MAX_FALLBACK_SIZE) {
-                fallback.append(data, length);
+                appendFallback(data, length);
+                /* We just failed parsing this, so it cannot hold a complete header block */
+                fallbackScanned = fallbackLength;
             } else {
                 return errorHandler(user);
             }
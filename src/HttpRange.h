@@ -0,0 +1,102 @@
+/*
+ * Authored by Alex Hultman, 2018-2023.
+ * Intellectual property of third-party.
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *     http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* This module parses the Range request header (RFC 9110, 14.2) for a representation of known size.
+ * We only serve a single byte range, anything else gets the whole representation as the spec allows */
+
+#ifndef UWS_HTTPRANGE_H
+#define UWS_HTTPRANGE_H
+
+#include <string_view>
+#include <cstdint>
+
+namespace uWS {
+
+    enum RangeResult {
+        /* No range, or one we ignore: send the whole thing with 200 */
+        RANGE_NONE,
+        /* Send [offset, offset + length) with 206 */
+        RANGE_PARTIAL,
+        /* Nothing of the range exists: 416 */
+        RANGE_UNSATISFIABLE
+    };
+
+    /* Parses a run of digits, saturating on overflow. Returns false if there are none */
+    static inline bool parseRangeNumber(std::string_view &header, uintmax_t &value) {
+        size_t digits = 0;
+        value = 0;
+        for (; digits < header.length() && header[digits] >= '0' && header[digits] <= '9'; digits++) {
+            uintmax_t digit = (uintmax_t) (header[digits] - '0');
+            value = value > (UINTMAX_MAX - digit) / 10 ? UINTMAX_MAX : value * 10 + digit;
+        }
+        header.remove_prefix(digits);
+        return digits != 0;
+    }
+
+    /* Parses the Range header against a representation of size bytes, setting offset and length for partial results */
+    static inline RangeResult parseRange(std::string_view header, uintmax_t size, uintmax_t &offset, uintmax_t &length) {
+        /* The range unit is case-insensitive */
+        if (header.length() < 6 || (header[0] | 32) != 'b' || (header[1] | 32) != 'y' || (header[2] | 32) != 't' || (header[3] | 32) != 'e' || (header[4] | 32) != 's' || header[5] != '=') {
+            return RANGE_NONE;
+        }
+        header.remove_prefix(6);
+
+        auto skipSpace = [&header]() {
+            while (header.length() && (header[0] == ' ' || header[0] == '\t')) {
+                header.remove_prefix(1);
+            }
+        };
+        skipSpace();
+
+        uintmax_t first = 0, last = 0;
+        bool hasFirst = parseRangeNumber(header, first);
+        if (!header.length() || header[0] != '-') {
+            return RANGE_NONE;
+        }
+        header.remove_prefix(1);
+        bool hasLast = parseRangeNumber(header, last);
+        skipSpace();
+
+        /* Multiple ranges and garbage are ignored */
+        if (header.length() || (!hasFirst && !hasLast) || (hasFirst && hasLast && first > last)) {
+            return RANGE_NONE;
+        }
+
+        if (!hasFirst) {
+            /* A suffix of last bytes */
+            if (!last || !size) {
+                return RANGE_UNSATISFIABLE;
+            }
+            length = last < size ? last : size;
+            offset = size - length;
+            return RANGE_PARTIAL;
+        }
+
+        if (first >= size) {
+            return RANGE_UNSATISFIABLE;
+        }
+        if (!hasLast || last >= size) {
+            last = size - 1;
+        }
+        offset = first;
+        length = last - first + 1;
+        return RANGE_PARTIAL;
+    }
+
+}
+
+#endif // UWS_HTTPRANGE_H
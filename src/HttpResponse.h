@@ -32,6 +32,21 @@
 #include "WebSocketContextData.h"
 
 #include "MoveOnlyFunction.h"
+#include "PreparedResponse.h"
+#include "HttpRange.h"
+
+#include <type_traits>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <cerrno>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#include <csignal>
+#include <ctime>
+#include <pthread.h>
+#endif
+#endif
 
 /* todo: tryWrite is missing currently, only send smaller segments with write */
 
@@ -53,13 +68,75 @@ private:
         return (HttpResponseData<SSL> *) Super::getAsyncSocketData();
     }
 
-    /* Write an unsigned 32-bit integer in hex */
-    void writeUnsignedHex(unsigned int value) {
-        char buf[10];
-        int length = utils::u32toaHex(value, buf);
+    /* When we are done with a response we mark it like so. If onData stopped reading, nobody will
+     * resume it now: drop the rest of the body and read on for the next request */
+    void markDone() {
+        HttpResponseData<SSL> *httpResponseData = getHttpResponseData();
+        httpResponseData->markDone();
+
+        if (httpResponseData->dataFlow.isStopped()) {
+            /* Stopped means we are not within onData, so it can go */
+            httpResponseData->dataFlow.reset();
+            httpResponseData->inStream = nullptr;
+            if (!us_socket_is_closed(SSL, (us_socket_t *) this)) {
+                Super::resumeReading();
+            }
+        }
+    }
 
-        /* For now we do this copy */
-        Super::write(buf, length);
+    /* Formats the "\r\n<hex length>\r\n" framing in front of a chunk, returning its length (at most 12) */
+    static int formatChunkHeader(unsigned int length, char *dst) {
+        dst[0] = '\r';
+        dst[1] = '\n';
+        int hexLength = utils::u32toaHex(length, dst + 2);
+        dst[2 + hexLength] = '\r';
+        dst[3 + hexLength] = '\n';
+        return hexLength + 4;
+    }
+
+    /* Writes the parts as one chunk. Small chunks are framed in one reservation of the send buffer,
+     * large ones get their framing written with a hint of what follows. Returns whether we failed */
+    bool writeChunk(const std::string_view *parts, size_t numParts) {
+        size_t length = 0;
+        for (size_t i = 0; i < numParts; i++) {
+            length += parts[i].length();
+        }
+
+        char header[12];
+        int headerLength = formatChunkHeader((unsigned int) length, header);
+
+        size_t frameLength = (size_t) headerLength + length;
+        if (frameLength < Super::getLoopData()->corkBufferSize) {
+            auto [sendBuffer, sendBufferAttribute] = Super::getSendBuffer(frameLength);
+
+            memcpy(sendBuffer, header, (size_t) headerLength);
+            sendBuffer += headerLength;
+            for (size_t i = 0; i < numParts; i++) {
+                memcpy(sendBuffer, parts[i].data(), parts[i].length());
+                sendBuffer += parts[i].length();
+            }
+
+            if (sendBufferAttribute == SendBufferAttribute::NEEDS_DRAIN) {
+                return Super::write(nullptr, 0).second;
+            } else if (sendBufferAttribute == SendBufferAttribute::NEEDS_UNCORK) {
+                return Super::uncork().second;
+            }
+            return false;
+        }
+
+        /* Uncorked plain sockets send the framing and a single part in one syscall */
+        if (!SSL && numParts == 1 && !Super::isCorked() && !Super::getBufferedAmount()) {
+            return Super::writeVectored(header, headerLength, parts[0].data(), (int) parts[0].length()).second;
+        }
+
+        /* Corked, the framing is sent along with the first part as it overflows the cork buffer (see uncork).
+         * Otherwise it goes out with MSG_MORE so that the kernel merges it with the payload */
+        bool failed = Super::write(header, headerLength, false, (int) length).second;
+        for (size_t i = 0; i < numParts; i++) {
+            size_t nextLength = i + 1 < numParts ? parts[i + 1].length() : 0;
+            failed |= Super::write(parts[i].data(), (int) parts[i].length(), false, (int) nextLength).second;
+        }
+        return failed;
     }
 
     /* Write an unsigned 64-bit integer */
@@ -85,6 +162,27 @@ private:
 #endif
     }
 
+    /* The loop's compression buffers, shared with WebSockets */
+    ZlibContext *getZlibContext() {
+        LoopData *loopData = Super::getLoopData();
+        if (!loopData->zlibContext) {
+            loopData->zlibContext = new ZlibContext;
+        }
+        return loopData->zlibContext;
+    }
+
+    /* Compresses a body given as a whole with the loop's stream of our encoding */
+    std::string_view compressWhole(std::string_view data) {
+        HttpResponseData<SSL> *httpResponseData = getHttpResponseData();
+        HttpCompressionStream *&compressionStream = Super::getLoopData()->httpCompressionStreams[httpResponseData->encoding];
+        if (!compressionStream) {
+            compressionStream = new HttpCompressionStream(httpResponseData->encoding);
+        }
+        std::string_view compressed = compressionStream->compress(getZlibContext(), data, true);
+        compressionStream->reset();
+        return compressed;
+    }
+
     /* Returns true on success, indicating that it might be feasible to write more data.
      * Will start timeout if stream reaches totalSize or write failure. */
     bool internalEnd(std::string_view data, uintmax_t totalSize, bool optional, bool allowContentLength = true, bool closeConnection = false) {
@@ -113,24 +211,43 @@ private:
             httpResponseData->state |= HttpResponseData<SSL>::HTTP_CONNECTION_CLOSE;
         }
 
+        if (httpResponseData->encoding) {
+            if (httpResponseData->state & HttpResponseData<SSL>::HTTP_WRITE_CALLED) {
+                /* The end of a compressed chunked body */
+                data = httpResponseData->compressionStream->compress(getZlibContext(), data, true);
+            } else if (httpResponseData->state & HttpResponseData<SSL>::HTTP_END_CALLED) {
+                /* Already decided */
+            } else if (allowContentLength && totalSize == data.length() && data.length() >= HTTP_COMPRESSION_MIN_SIZE) {
+                writeHeader("Content-Encoding", getEncodingName(httpResponseData->encoding));
+                writeHeader("Vary", "Accept-Encoding");
+                data = compressWhole(data);
+                totalSize = data.length();
+
+                /* Offsets of a retried tryEnd would be in raw bytes, so we write the whole thing now */
+                optional = false;
+            } else {
+                /* Too small, or a body given in parts whose offsets are in raw bytes */
+                if (allowContentLength) {
+                    writeHeader("Vary", "Accept-Encoding");
+                }
+                httpResponseData->encoding = ENCODING_IDENTITY;
+            }
+        }
+
         if (httpResponseData->state & HttpResponseData<SSL>::HTTP_WRITE_CALLED) {
 
             /* We do not have tryWrite-like functionalities, so ignore optional in this path */
 
             /* Do not allow sending 0 chunk here */
             if (data.length()) {
-                Super::write("\r\n", 2);
-                writeUnsignedHex((unsigned int) data.length());
-                Super::write("\r\n", 2);
-
                 /* Ignoring optional for now */
-                Super::write(data.data(), (int) data.length());
+                writeChunk(&data, 1);
             }
 
             /* Terminating 0 chunk */
             Super::write("\r\n0\r\n\r\n", 7);
 
-            httpResponseData->markDone();
+            markDone();
 
             /* We need to check if we should close this socket here now */
             if (!Super::isCorked()) {
@@ -196,7 +313,7 @@ private:
 
             /* Remove onAborted function if we reach the end */
             if (httpResponseData->offset == totalSize) {
-                httpResponseData->markDone();
+                markDone();
 
                 /* We need to check if we should close this socket here now */
                 if (!Super::isCorked()) {
@@ -217,6 +334,113 @@ private:
         }
     }
 
+#ifdef __linux__
+    /* Unlike send, sendfile has no MSG_NOSIGNAL, and a peer gone away would kill the process with SIGPIPE.
+     * So we block it on this thread while sending a file, and take back one we raised before anyone else can get it */
+    struct SigPipeBlock {
+        sigset_t pipeSet, oldSet;
+        bool blocked, wasPending = false;
+        /* Set when a send failed with EPIPE */
+        bool raised = false;
+
+        SigPipeBlock(bool block) : blocked(block) {
+            if (blocked) {
+                sigemptyset(&pipeSet);
+                sigaddset(&pipeSet, SIGPIPE);
+                pthread_sigmask(SIG_BLOCK, &pipeSet, &oldSet);
+
+                /* One already pending is not ours to take */
+                sigset_t pendingSet;
+                sigpending(&pendingSet);
+                wasPending = sigismember(&pendingSet, SIGPIPE);
+            }
+        }
+
+        ~SigPipeBlock() {
+            if (blocked) {
+                if (raised && !wasPending) {
+                    int savedErrno = errno;
+                    struct timespec noWait = {0, 0};
+                    while (sigtimedwait(&pipeSet, nullptr, &noWait) < 0 && errno == EINTR) {}
+                    errno = savedErrno;
+                }
+                pthread_sigmask(SIG_SETMASK, &oldSet, nullptr);
+            }
+        }
+    };
+#endif
+
+#ifndef _WIN32
+    /* Sends remaining bytes of the file from fileOffset, after draining what is corked or buffered before it.
+     * Cleartext sockets use sendfile where we have it. When the socket is full, or under TLS, the file is read
+     * through the normal write path, which buffers what did not fit and polls for writable.
+     * Returns true when all is sent (and the response done), false if waiting for writable or closed */
+    bool sendFileRemainder(int fd, uintmax_t &fileOffset, uintmax_t &remaining) {
+        HttpResponseData<SSL> *httpResponseData = getHttpResponseData();
+
+        /* Headers, and anything before them, go first */
+        if (Super::isCorked() && Super::uncork().second) {
+            return false;
+        }
+        if (Super::getBufferedAmount() && Super::write(nullptr, 0).second) {
+            return false;
+        }
+
+#ifdef __linux__
+        /* Once for all of the sendfile calls below */
+        SigPipeBlock sigPipeBlock(!SSL && remaining);
+#endif
+
+        while (remaining) {
+#ifdef __linux__
+            if constexpr (!SSL) {
+                int socketFd = (int) (uintptr_t) us_socket_get_native_handle(SSL, (us_socket_t *) this);
+                off_t sendOffset = (off_t) fileOffset;
+                ssize_t sent = sendfile(socketFd, fd, &sendOffset, (size_t) std::min<uintmax_t>(remaining, INT_MAX));
+                if (sent > 0) {
+                    fileOffset += (uintmax_t) sent;
+                    remaining -= (uintmax_t) sent;
+                    httpResponseData->offset += (uintmax_t) sent;
+                    continue;
+                }
+                if (sent < 0 && errno == EINTR) {
+                    continue;
+                }
+                sigPipeBlock.raised |= sent < 0 && errno == EPIPE;
+                /* EAGAIN falls through to a read, which arms polling for writable. Other errors show there as well */
+            }
+#endif
+            char buffer[16 * 1024];
+            ssize_t length = pread(fd, buffer, (size_t) std::min<uintmax_t>(remaining, sizeof(buffer)), (off_t) fileOffset);
+            if (length <= 0) {
+                /* The file is shorter than promised or unreadable, we can only close */
+                Super::close();
+                return false;
+            }
+            fileOffset += (uintmax_t) length;
+            remaining -= (uintmax_t) length;
+            httpResponseData->offset += (uintmax_t) length;
+
+            if (Super::write(buffer, (int) length).second) {
+                return false;
+            }
+        }
+
+        markDone();
+
+        /* We need to check if we should close this socket here now */
+        if (httpResponseData->state & HttpResponseData<SSL>::HTTP_CONNECTION_CLOSE) {
+            if (((AsyncSocket<SSL> *) this)->getBufferedAmount() == 0) {
+                ((AsyncSocket<SSL> *) this)->shutdown();
+                /* We need to force close after sending FIN since we want to hinder
+                 * clients from keeping to send their huge data */
+                ((AsyncSocket<SSL> *) this)->close();
+            }
+        }
+        return true;
+    }
+#endif
+
 public:
     /* If we have proxy support; returns the proxed source address as reported by the proxy. */
 #ifdef UWS_WITH_PROXY
@@ -368,6 +592,39 @@ public:
         return this;
     }
 
+    /* Continue reading after onData returned false, starting with what was read before we stopped.
+     * Reading stays stopped if onData returns false again */
+    HttpResponse *resumeData() {
+        HttpResponseData<SSL> *httpResponseData = getHttpResponseData();
+        if (!httpResponseData->dataFlow.isStopped()) {
+            return this;
+        }
+
+        bool gotFin = false;
+        bool flowing = httpResponseData->dataFlow.resume([httpResponseData, &gotFin](std::string_view chunk, bool fin) {
+            gotFin = fin;
+            return !httpResponseData->inStream || httpResponseData->inStream(chunk, fin);
+        });
+
+        /* The handler may have closed us */
+        if (us_socket_is_closed(SSL, (us_socket_t *) this)) {
+            return this;
+        }
+
+        if (gotFin) {
+            httpResponseData->inStream = nullptr;
+        }
+
+        if (flowing) {
+            Super::resumeReading();
+            /* Only time out the client if we still wait for its data */
+            if (httpResponseData->inStream) {
+                Super::timeout(HTTP_TIMEOUT_S);
+            }
+        }
+        return this;
+    }
+
     /* Note: Headers are not checked in regards to timeout.
      * We only check when you actively push data or end the request */
 
@@ -431,18 +688,208 @@ public:
         internalEnd(data, data.length(), false, true, closeConnection);
     }
 
+    /* End the response with a body held in a SharedBuffer. Bodies too large for the cork buffer are not copied
+     * to backpressure, it refers to the SharedBuffer until written off instead. Release your reference whenever */
+    void end(SharedBuffer *body, bool closeConnection = false) {
+        HttpResponseData<SSL> *httpResponseData = getHttpResponseData();
+
+        /* Small, compressed or chunked bodies take the usual path */
+        if (body->length() < Super::getLoopData()->corkBufferSize || httpResponseData->encoding
+            || (httpResponseData->state & (HttpResponseData<SSL>::HTTP_WRITE_CALLED | HttpResponseData<SSL>::HTTP_END_CALLED))) {
+            end(std::string_view(body->data(), body->length()), closeConnection);
+            return;
+        }
+
+        /* Status, mark and Content-Length, but no body */
+        internalEnd({nullptr, 0}, body->length(), false, true, closeConnection);
+
+        Super::writeShared(body);
+        httpResponseData->offset += body->length();
+        markDone();
+        Super::timeout(HTTP_TIMEOUT_S);
+
+        /* We need to check if we should close this socket here now */
+        if (!Super::isCorked()) {
+            if (httpResponseData->state & HttpResponseData<SSL>::HTTP_CONNECTION_CLOSE) {
+                if ((httpResponseData->state & HttpResponseData<SSL>::HTTP_RESPONSE_PENDING) == 0) {
+                    if (((AsyncSocket<SSL> *) this)->getBufferedAmount() == 0) {
+                        ((AsyncSocket<SSL> *) this)->shutdown();
+                        /* We need to force close after sending FIN since we want to hinder
+                         * clients from keeping to send their huge data */
+                        ((AsyncSocket<SSL> *) this)->close();
+                    }
+                }
+            }
+        }
+    }
+
+    /* End the response with a PreparedResponse, in one copy. If status or headers were already written,
+     * its headers and body are written the usual way instead. Always starts a timeout. */
+    void end(const PreparedResponse &preparedResponse) {
+        HttpResponseData<SSL> *httpResponseData = getHttpResponseData();
+
+        if (httpResponseData->state & (HttpResponseData<SSL>::HTTP_STATUS_CALLED | HttpResponseData<SSL>::HTTP_WRITE_CALLED | HttpResponseData<SSL>::HTTP_END_CALLED)) {
+            std::string_view headers = preparedResponse.getHeaders();
+            if (!(httpResponseData->state & (HttpResponseData<SSL>::HTTP_WRITE_CALLED | HttpResponseData<SSL>::HTTP_END_CALLED))) {
+                Super::write(headers.data(), (int) headers.length());
+            }
+            end(preparedResponse.getBody());
+            return;
+        }
+        httpResponseData->state |= HttpResponseData<SSL>::HTTP_STATUS_CALLED | HttpResponseData<SSL>::HTTP_END_CALLED;
+
+        /* Leave the mark out if we are to be silent */
+        std::string_view data = preparedResponse.data();
+        size_t markOffset = preparedResponse.markOffset;
+        size_t markLength = Super::getLoopData()->noMark ? preparedResponse.markLength : 0;
+        size_t length = data.length() - markLength;
+
+        if (length < Super::getLoopData()->corkBufferSize) {
+            auto [sendBuffer, sendBufferAttribute] = Super::getSendBuffer(length);
+            memcpy(sendBuffer, data.data(), markOffset);
+            memcpy(sendBuffer + markOffset, data.data() + markOffset + markLength, data.length() - markOffset - markLength);
+            memcpy(sendBuffer + preparedResponse.dateOffset, Super::getLoopData()->date, PreparedResponse::DATE_LENGTH);
+
+            if (sendBufferAttribute == SendBufferAttribute::NEEDS_DRAIN) {
+                Super::write(nullptr, 0);
+            } else if (sendBufferAttribute == SendBufferAttribute::NEEDS_UNCORK) {
+                Super::uncork();
+            }
+        } else {
+            /* Large bodies are written in pieces around the date */
+            size_t dateEnd = preparedResponse.dateOffset + PreparedResponse::DATE_LENGTH;
+            Super::write(data.data(), (int) preparedResponse.dateOffset);
+            Super::write(Super::getLoopData()->date, (int) PreparedResponse::DATE_LENGTH);
+            Super::write(data.data() + dateEnd, (int) (markOffset - dateEnd));
+            std::string_view rest = data.substr(markOffset + markLength);
+            for (size_t written = 0; written < rest.length(); ) {
+                /* uSockets only deals with int sizes, so pass chunks of max signed int size */
+                written += (size_t) Super::write(rest.data() + written, (int) std::min<size_t>(rest.length() - written, INT_MAX)).first;
+            }
+        }
+
+        httpResponseData->offset += preparedResponse.getBody().length();
+        markDone();
+        Super::timeout(HTTP_TIMEOUT_S);
+
+        /* We need to check if we should close this socket here now */
+        if (!Super::isCorked()) {
+            if (httpResponseData->state & HttpResponseData<SSL>::HTTP_CONNECTION_CLOSE) {
+                if (((AsyncSocket<SSL> *) this)->getBufferedAmount() == 0) {
+                    ((AsyncSocket<SSL> *) this)->shutdown();
+                    /* We need to force close after sending FIN since we want to hinder
+                     * clients from keeping to send their huge data */
+                    ((AsyncSocket<SSL> *) this)->close();
+                }
+            }
+        }
+    }
+
+#ifndef _WIN32
+    /* End the response with length bytes of the open file fd, starting at offset. Status and headers go
+     * through the cork buffer, the body follows with sendfile on cleartext sockets (reads under TLS).
+     * SIGPIPE is blocked on the calling thread around sendfile, so a peer gone away cannot kill the process.
+     * This takes over onWritable until done, the fd must stay open until then or until onAborted.
+     * Returns true if all was sent right away. Always starts a timeout. */
+    bool sendFile(int fd, uintmax_t offset, uintmax_t length) {
+        if (!length) {
+            end();
+            return true;
+        }
+
+        /* Status, mark and Content-Length, but no body */
+        internalEnd({nullptr, 0}, length, false);
+
+        if (sendFileRemainder(fd, offset, length)) {
+            Super::timeout(HTTP_TIMEOUT_S);
+            return true;
+        }
+
+        /* A file shorter than promised has us close, and our data is gone with the socket */
+        if (us_socket_is_closed(SSL, (us_socket_t *) this)) {
+            return false;
+        }
+
+        /* The response is in our hands, so returning from the handler is fine even without onAborted */
+        HttpResponseData<SSL> *httpResponseData = getHttpResponseData();
+        if (!httpResponseData->onAborted) {
+            httpResponseData->onAborted = []() {};
+        }
+        httpResponseData->onWritable = [this, fd, offset, length](uintmax_t) mutable {
+            bool done = sendFileRemainder(fd, offset, length);
+            if (!us_socket_is_closed(SSL, (us_socket_t *) this)) {
+                Super::timeout(HTTP_TIMEOUT_S);
+            }
+            return done;
+        };
+        Super::timeout(HTTP_TIMEOUT_S);
+        return false;
+    }
+
+    /* Like sendFile, but for the whole file of fileSize bytes as asked for by the Range header (if any).
+     * A single byte range is sent with 206, an unsatisfiable one gets 416, anything else the whole file */
+    bool sendFile(int fd, uintmax_t fileSize, std::string_view range) {
+        uintmax_t offset = 0, length = fileSize;
+        RangeResult rangeResult = parseRange(range, fileSize, offset, length);
+
+        char contentRange[64];
+        if (rangeResult == RANGE_UNSATISFIABLE) {
+            int contentRangeLength = snprintf(contentRange, sizeof(contentRange), "bytes */%ju", fileSize);
+            writeStatus("416 Range Not Satisfiable");
+            writeHeader("Content-Range", std::string_view(contentRange, (size_t) contentRangeLength));
+            end();
+            return true;
+        }
+
+        if (rangeResult == RANGE_PARTIAL) {
+            int contentRangeLength = snprintf(contentRange, sizeof(contentRange), "bytes %ju-%ju/%ju", offset, offset + length - 1, fileSize);
+            writeStatus("206 Partial Content");
+            writeHeader("Content-Range", std::string_view(contentRange, (size_t) contentRangeLength));
+        }
+        writeHeader("Accept-Ranges", "bytes");
+        return sendFile(fd, offset, length);
+    }
+#endif
+
     /* Try and end the response. Returns [true, true] on success.
      * Starts a timeout in some cases. Returns [ok, hasResponded] */
     std::pair<bool, bool> tryEnd(std::string_view data, uintmax_t totalSize = 0, bool closeConnection = false) {
         return {internalEnd(data, totalSize, true, true, closeConnection), hasResponded()};
     }
 
+    /* Compress the body with the encoding the client prefers by its Accept-Encoding, if we support any.
+     * Applies to bodies given whole to end or tryEnd (of at least HTTP_COMPRESSION_MIN_SIZE bytes)
+     * and to bodies written in pieces with write, ended by end */
+    HttpResponse *compress(std::string_view acceptEncoding) {
+        HttpResponseData<SSL> *httpResponseData = getHttpResponseData();
+
+        /* Too late if the body has begun */
+        if (!(httpResponseData->state & (HttpResponseData<SSL>::HTTP_WRITE_CALLED | HttpResponseData<SSL>::HTTP_END_CALLED))) {
+            httpResponseData->encoding = negotiateEncoding(acceptEncoding, COMPRESSIBLE_ENCODINGS);
+        }
+        return this;
+    }
+
     /* Write parts of the response in chunking fashion. Starts timeout if failed. */
     bool write(std::string_view data) {
+        return writeChunks(&data, 1);
+    }
+
+    /* Write many small parts, such as server-sent events, in one call. They go out framed as one chunk,
+     * chunk boundaries carry no meaning in HTTP. Starts timeout if failed. */
+    bool writeChunks(std::initializer_list<std::string_view> parts) {
+        return writeChunks(parts.begin(), parts.size());
+    }
+
+    bool writeChunks(const std::string_view *parts, size_t numParts) {
         writeStatus(HTTP_200_OK);
 
         /* Do not allow sending 0 chunks, they mark end of response */
-        if (!data.length()) {
+        size_t length = 0;
+        for (size_t i = 0; i < numParts; i++) {
+            length += parts[i].length();
+        }
+        if (!length) {
             /* If you called us, then according to you it was fine to call us so it's fine to still call us */
             return true;
         }
@@ -453,15 +900,25 @@ public:
             /* Write mark on first call to write */
             writeMark();
 
+            /* Bodies written in pieces get a stream of their own */
+            if (httpResponseData->encoding) {
+                writeHeader("Content-Encoding", getEncodingName(httpResponseData->encoding));
+                writeHeader("Vary", "Accept-Encoding");
+                httpResponseData->compressionStream = new HttpCompressionStream(httpResponseData->encoding);
+            }
+
             writeHeader("Transfer-Encoding", "chunked");
             httpResponseData->state |= HttpResponseData<SSL>::HTTP_WRITE_CALLED;
         }
 
-        Super::write("\r\n", 2);
-        writeUnsignedHex((unsigned int) data.length());
-        Super::write("\r\n", 2);
-
-        auto [written, failed] = Super::write(data.data(), (int) data.length());
+        bool failed;
+        if (httpResponseData->compressionStream) {
+            /* Flushed, so that clients can decode what they got so far */
+            std::string_view compressed = httpResponseData->compressionStream->compress(getZlibContext(), parts, numParts, false);
+            failed = writeChunk(&compressed, 1);
+        } else {
+            failed = writeChunk(parts, numParts);
+        }
         if (failed) {
             Super::timeout(HTTP_TIMEOUT_S);
         }
@@ -560,10 +1017,20 @@ public:
         return this;
     }
 
-    /* Attach a read handler for data sent. Will be called with FIN set true if last segment. */
-    void onData(MoveOnlyFunction<void(std::string_view, bool)> &&handler) {
+    /* Attach a read handler for data sent. Will be called with FIN set true if last segment.
+     * A handler returning bool may return false to stop reading, until resumeData is called.
+     * Ending the response while stopped drops the rest of the body, and stopping once responded closes the connection */
+    template <typename F>
+    void onData(F &&handler) {
         HttpResponseData<SSL> *data = getHttpResponseData();
-        data->inStream = std::move(handler);
+        if constexpr (std::is_same_v<std::decay_t<F>, std::nullptr_t> || std::is_invocable_r_v<bool, F &, std::string_view, bool>) {
+            data->inStream = std::forward<F>(handler);
+        } else {
+            data->inStream = [handler = std::forward<F>(handler)](std::string_view chunk, bool fin) mutable {
+                handler(chunk, fin);
+                return true;
+            };
+        }
 
         /* Always reset this counter here */
         data->received_bytes_per_timeout = 0;
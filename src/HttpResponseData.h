@@ -23,6 +23,8 @@
 #include "HttpParser.h"
 #include "AsyncSocketData.h"
 #include "ProxyParser.h"
+#include "HttpCompression.h"
+#include "DataFlow.h"
 
 #include "MoveOnlyFunction.h"
 
@@ -41,6 +43,15 @@ struct HttpResponseData : AsyncSocketData<SSL>, HttpParser {
 
         /* We are done with this request */
         state &= ~HttpResponseData<SSL>::HTTP_RESPONSE_PENDING;
+
+        /* Compression is per response */
+        delete compressionStream;
+        compressionStream = nullptr;
+        encoding = ENCODING_IDENTITY;
+    }
+
+    ~HttpResponseData() {
+        delete compressionStream;
     }
 
     /* Caller of onWritable. It is possible onWritable calls markDone so we need to borrow it. */
@@ -75,7 +86,9 @@ private:
     /* Per socket event handlers */
     MoveOnlyFunction<bool(uintmax_t)> onWritable;
     MoveOnlyFunction<void()> onAborted;
-    MoveOnlyFunction<void(std::string_view, bool)> inStream; // onData
+    MoveOnlyFunction<bool(std::string_view, bool)> inStream; // onData
+    /* Whether onData asked us to stop reading, and what we read before we could */
+    DataFlow dataFlow;
     /* Outgoing offset */
     uintmax_t offset = 0;
 
@@ -85,6 +98,10 @@ private:
     /* Current state (content-length sent, status sent, write called, etc */
     int state = 0;
 
+    /* Negotiated by compress, with a stream of our own only for bodies written in pieces */
+    HttpEncoding encoding = ENCODING_IDENTITY;
+    HttpCompressionStream *compressionStream = nullptr;
+
 #ifdef UWS_WITH_PROXY
     ProxyParser proxyParser;
 #endif
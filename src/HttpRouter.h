@@ -18,8 +18,9 @@
 #ifndef UWS_HTTPROUTER_HPP
 #define UWS_HTTPROUTER_HPP
 
-#include <map>
 #include <vector>
+#include <unordered_map>
+#include <unordered_set>
 #include <cstring>
 #include <string_view>
 #include <string>
@@ -30,13 +31,14 @@
 #include <iostream>
 
 #include "MoveOnlyFunction.h"
+#include "UrlDecoder.h"
 
 namespace uWS {
 
 template <class USERDATA>
 struct HttpRouter {
     /* These are public for now */
-    std::vector<std::string> upperCasedMethods = {"GET", "POST", "HEAD", "PUT", "DELETE", "CONNECT", "OPTIONS", "TRACE", "PATCH"};
+    std::vector<std::string_view> upperCasedMethods = {"GET", "POST", "HEAD", "PUT", "DELETE", "CONNECT", "OPTIONS", "TRACE", "PATCH"};
     static const uint32_t HIGH_PRIORITY = 0xd0000000, MEDIUM_PRIORITY = 0xe0000000, LOW_PRIORITY = 0xf0000000;
 
 private:
@@ -46,29 +48,148 @@ private:
     /* Handler ids are 32-bit */
     static const uint32_t HANDLER_MASK = 0x0fffffff;
 
-    /* Methods and their respective priority */
-    std::map<std::string, int> priority;
-
-    /* List of handlers */
-    std::vector<MoveOnlyFunction<bool(HttpRouter *)>> handlers;
+    /* List of handlers, called through const routers when shared */
+    mutable std::vector<MoveOnlyFunction<bool(HttpRouter *)>> handlers;
 
     /* Current URL cache */
     std::string_view currentUrl;
     std::string_view urlSegmentVector[MAX_URL_SEGMENTS];
     int urlSegmentTop;
 
+    /* Node names are views into this arena, every distinct name is stored once */
+    struct NameArena {
+        static const size_t BLOCK_SIZE = 4096;
+        std::vector<std::unique_ptr<char[]>> blocks;
+        char *block = nullptr;
+        size_t blockLeft = 0;
+        std::unordered_set<std::string_view> names;
+
+        std::string_view intern(std::string_view name) {
+            auto it = names.find(name);
+            if (it != names.end()) {
+                return *it;
+            }
+
+            /* Long names get a block of their own */
+            char *data;
+            if (name.length() > BLOCK_SIZE / 4) {
+                blocks.emplace_back(new char[name.length()]);
+                data = blocks.back().get();
+            } else {
+                if (name.length() > blockLeft) {
+                    blocks.emplace_back(new char[BLOCK_SIZE]);
+                    block = blocks.back().get();
+                    blockLeft = BLOCK_SIZE;
+                }
+                data = block;
+                block += name.length();
+                blockLeft -= name.length();
+            }
+            std::copy(name.begin(), name.end(), data);
+            return *names.emplace(data, name.length()).first;
+        }
+    } nameArena;
+
     /* The matching tree */
     struct Node {
-        std::string name;
+        std::string_view name;
         std::vector<std::unique_ptr<Node>> children;
         std::vector<uint32_t> handlers;
         bool isHighPriority;
+        /* Children are appended as added and put in matching order when compiling */
+        bool isSorted = true;
 
-        Node(std::string name) : name(name) {}
+        Node(std::string_view name) : name(name) {}
     } root = {"rootNode"};
 
+    /* Looks up the child of a given name and priority without scanning, since nodes can have many thousands of children */
+    struct ChildKey {
+        Node *parent;
+        std::string_view name;
+        bool isHighPriority;
+
+        bool operator==(const ChildKey &other) const {
+            return parent == other.parent && isHighPriority == other.isHighPriority && name == other.name;
+        }
+    };
+
+    struct ChildKeyHash {
+        size_t operator()(const ChildKey &key) const {
+            return std::hash<std::string_view>()(key.name) ^ (std::hash<Node *>()(key.parent) * 31) ^ key.isHighPriority;
+        }
+    };
+
+    std::unordered_map<ChildKey, Node *, ChildKeyHash> childIndex;
+
+    /* Flat, read-only copy of the matching tree used by route(). Every node is a range of handlers
+     * and a range of steps, where consecutive static children of same priority are merged into one
+     * step since at most one of them can match a segment. Rebuilt lazily after add and remove */
+    struct CompiledNode {
+        uint32_t handlersBegin, handlersEnd;
+        uint32_t stepsBegin, stepsEnd;
+    };
+
+    struct CompiledStep {
+        enum Kind : uint32_t {
+            STATIC,
+            PARAMETER,
+            WILDCARD
+        } kind;
+        /* Node to enter (parameter) or whose handlers to execute (wildcard) */
+        uint32_t node;
+        /* Static children [staticBegin, staticEnd) in compiledStatics, with an optional first-byte jump table */
+        uint32_t staticBegin, staticEnd;
+        uint32_t jumpTable;
+    };
+
+    struct CompiledStatic {
+        uint32_t nameOffset, nameLength;
+        uint32_t node;
+    };
+
+    /* Static children of a node get a first-byte jump table when there are this many of them */
+    static const unsigned int JUMP_TABLE_THRESHOLD = 8;
+    static const uint32_t NO_JUMP_TABLE = UINT32_MAX;
+
+    bool isCompiled = false;
+    std::vector<CompiledNode> compiledNodes;
+    std::vector<CompiledStep> compiledSteps;
+    std::vector<CompiledStatic> compiledStatics;
+    std::vector<uint32_t> compiledHandlers;
+    /* Ranges [jumpTable + c, jumpTable + c + 1) in compiledStatics for first byte c */
+    std::vector<uint32_t> compiledJumpTables;
+    std::string compiledNames;
+    /* Method names and their compiled node, in the order of root children */
+    std::vector<std::pair<std::string_view, uint32_t>> compiledMethods;
+
+    /* Router whose compiled tree and handlers route() uses, either this one or a shared one */
+    const HttpRouter *table = this;
+    std::shared_ptr<const HttpRouter> sharedTable;
+
+    /* Some of our routes only work on our thread, see bindToThread */
+    bool threadBound = false;
+
+    /* Optional direct-mapped cache from method and URL to every handler route() would try, in order.
+     * Only URLs not binding any parameter can be replayed, so that replaying gives the exact same result.
+     * Other URLs are remembered as such, so that we only try collecting their handlers once */
+    struct CacheEntry {
+        /* Method, space, URL */
+        std::string key;
+        /* Entries from earlier compilations are stale */
+        uint32_t generation = 0;
+        bool replayable = false;
+        std::vector<uint32_t> handlers;
+    };
+    std::vector<CacheEntry> cache;
+    uint32_t cacheGeneration = 1;
+    unsigned long long cacheHits = 0, cacheMisses = 0;
+
+    /* Optionally we route a percent-decoded and normalized copy of the URL, so parameters are decoded as well */
+    bool normalizesUrls = false;
+    std::string normalizedUrl;
+
     /* Sort wildcards after alphanum */
-    int lexicalOrder(std::string &name) {
+    static int lexicalOrder(std::string_view name) {
         if (!name.length()) {
             return 2;
         }
@@ -81,25 +202,47 @@ private:
         return 2;
     }
 
+    /* Returns child of given name and priority, or nullptr */
+    Node *findChild(Node *parent, std::string_view name, bool isHighPriority) {
+        auto it = childIndex.find({parent, name, isHighPriority});
+        return it == childIndex.end() ? nullptr : it->second;
+    }
+
     /* Advance from parent to child, adding child if necessary */
-    Node *getNode(Node *parent, std::string child, bool isHighPriority) {
-        for (std::unique_ptr<Node> &node : parent->children) {
-            if (node->name == child && node->isHighPriority == isHighPriority) {
-                return node.get();
-            }
+    Node *getNode(Node *parent, std::string_view child, bool isHighPriority) {
+        if (Node *node = findChild(parent, child, isHighPriority)) {
+            return node;
         }
 
-        /* Insert sorted, but keep order if parent is root (we sort methods by priority elsewhere) */
-        std::unique_ptr<Node> newNode(new Node(child));
+        std::unique_ptr<Node> newNode(new Node(nameArena.intern(child)));
         newNode->isHighPriority = isHighPriority;
-        return parent->children.emplace(std::upper_bound(parent->children.begin(), parent->children.end(), newNode, [parent, this](auto &a, auto &b) {
+        childIndex.emplace(ChildKey{parent, newNode->name, isHighPriority}, newNode.get());
 
-            if (a->isHighPriority != b->isHighPriority) {
-                return a->isHighPriority;
-            }
+        /* Appending only keeps the order if it sorts last (the common case when adding in order) */
+        if (parent->children.size() && matchingOrder(parent, newNode.get(), parent->children.back().get())) {
+            parent->isSorted = false;
+        }
+        parent->children.emplace_back(std::move(newNode));
+        return parent->children.back().get();
+    }
 
-            return b->name.length() && (parent != &root) && (lexicalOrder(b->name) < lexicalOrder(a->name));
-        }), std::move(newNode))->get();
+    /* High priority first, then static, parameter and wildcard. Keep order if parent is root (we sort methods by priority elsewhere) */
+    bool matchingOrder(Node *parent, Node *a, Node *b) {
+        if (a->isHighPriority != b->isHighPriority) {
+            return a->isHighPriority;
+        }
+
+        return b->name.length() && (parent != &root) && (lexicalOrder(b->name) < lexicalOrder(a->name));
+    }
+
+    /* Stable, so that this gives the same order as inserting every child sorted */
+    void sortChildren(Node *node) {
+        if (!node->isSorted) {
+            std::stable_sort(node->children.begin(), node->children.end(), [node, this](auto &a, auto &b) {
+                return matchingOrder(node, a.get(), b.get());
+            });
+            node->isSorted = true;
+        }
     }
 
     /* Basically a pre-allocated stack */
@@ -168,41 +311,124 @@ private:
         return {urlSegmentVector[urlSegment], false};
     }
 
+    /* Appends node (and recursively its children) to the compiled tree, returns its index */
+    uint32_t compileNode(Node *node) {
+        uint32_t index = (uint32_t) compiledNodes.size();
+        compiledNodes.push_back({});
+
+        sortChildren(node);
+
+        uint32_t handlersBegin = (uint32_t) compiledHandlers.size();
+        compiledHandlers.insert(compiledHandlers.end(), node->handlers.begin(), node->handlers.end());
+        uint32_t handlersEnd = (uint32_t) compiledHandlers.size();
+
+        /* Children first, their steps are laid out contiguously after */
+        std::vector<uint32_t> children;
+        for (auto &child : node->children) {
+            children.push_back(compileNode(child.get()));
+        }
+
+        uint32_t stepsBegin = (uint32_t) compiledSteps.size();
+        for (unsigned int i = 0; i < node->children.size(); i++) {
+            std::string_view name = node->children[i]->name;
+            if (name.length() && name[0] == '*') {
+                compiledSteps.push_back({CompiledStep::WILDCARD, children[i], 0, 0, NO_JUMP_TABLE});
+            } else if (name.length() && name[0] == ':') {
+                compiledSteps.push_back({CompiledStep::PARAMETER, children[i], 0, 0, NO_JUMP_TABLE});
+            } else {
+                /* Merge with the previous step if that is static as well, and of same priority (names are only unique per priority) */
+                if (compiledSteps.size() == stepsBegin || compiledSteps.back().kind != CompiledStep::STATIC || node->children[i - 1]->isHighPriority != node->children[i]->isHighPriority) {
+                    uint32_t staticBegin = (uint32_t) compiledStatics.size();
+                    compiledSteps.push_back({CompiledStep::STATIC, 0, staticBegin, staticBegin, NO_JUMP_TABLE});
+                }
+                compiledStatics.push_back({(uint32_t) compiledNames.length(), (uint32_t) name.length(), children[i]});
+                compiledNames.append(name);
+                compiledSteps.back().staticEnd++;
+            }
+        }
+
+        /* Sort bigger static steps by first byte (empty names first) and index them */
+        for (uint32_t i = stepsBegin; i < compiledSteps.size(); i++) {
+            CompiledStep &step = compiledSteps[i];
+            if (step.kind == CompiledStep::STATIC && step.staticEnd - step.staticBegin >= JUMP_TABLE_THRESHOLD) {
+                auto firstByte = [this](const CompiledStatic &s) {
+                    return s.nameLength ? (int) (unsigned char) compiledNames[s.nameOffset] : -1;
+                };
+                std::stable_sort(compiledStatics.begin() + step.staticBegin, compiledStatics.begin() + step.staticEnd, [&firstByte](const CompiledStatic &a, const CompiledStatic &b) {
+                    return firstByte(a) < firstByte(b);
+                });
+
+                step.jumpTable = (uint32_t) compiledJumpTables.size();
+                uint32_t s = step.staticBegin;
+                for (int c = 0; c < 256; c++) {
+                    for (; s < step.staticEnd && firstByte(compiledStatics[s]) < c; s++);
+                    compiledJumpTables.push_back(s);
+                }
+                compiledJumpTables.push_back(step.staticEnd);
+            }
+        }
+
+        compiledNodes[index] = {handlersBegin, handlersEnd, stepsBegin, (uint32_t) compiledSteps.size()};
+        return index;
+    }
+
+    /* Returns the static child named segment or UINT32_MAX */
+    inline uint32_t findStatic(const CompiledStep &step, std::string_view segment) {
+        uint32_t begin = step.staticBegin, end = step.staticEnd;
+        if (step.jumpTable != NO_JUMP_TABLE && segment.length()) {
+            const uint32_t *jumpTable = &table->compiledJumpTables[step.jumpTable + (unsigned char) segment[0]];
+            begin = jumpTable[0];
+            end = jumpTable[1];
+        }
+        for (uint32_t i = begin; i < end; i++) {
+            const CompiledStatic &s = table->compiledStatics[i];
+            if (s.nameLength == segment.length() && !memcmp(table->compiledNames.data() + s.nameOffset, segment.data(), segment.length())) {
+                return s.node;
+            }
+        }
+        return UINT32_MAX;
+    }
+
+    inline bool executeHandlers(uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; i++) {
+            if (table->handlers[table->compiledHandlers[i] & HANDLER_MASK](this)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     /* Executes as many handlers it can */
-    bool executeHandlers(Node *parent, int urlSegment, USERDATA &userData) {
+    bool executeCompiledHandlers(uint32_t node, int urlSegment) {
 
         auto [segment, isStop] = getUrlSegment(urlSegment);
+        const CompiledNode &compiledNode = table->compiledNodes[node];
 
         /* If we are on STOP, return where we may stand */
         if (isStop) {
-            /* We have reached accross the entire URL with no stoppage, execute */
-            for (uint32_t handler : parent->handlers) {
-                if (handlers[handler & HANDLER_MASK](this)) {
-                    return true;
-                }
-            }
-            /* We reached the end, so go back */
-            return false;
+            return executeHandlers(compiledNode.handlersBegin, compiledNode.handlersEnd);
         }
 
-        for (auto &p : parent->children) {
-            if (p->name.length() && p->name[0] == '*') {
+        for (uint32_t i = compiledNode.stepsBegin, end = compiledNode.stepsEnd; i < end; i++) {
+            const CompiledStep &step = table->compiledSteps[i];
+            if (step.kind == CompiledStep::WILDCARD) {
                 /* Wildcard match (can be seen as a shortcut) */
-                for (uint32_t handler : p->handlers) {
-                    if (handlers[handler & HANDLER_MASK](this)) {
+                if (executeHandlers(table->compiledNodes[step.node].handlersBegin, table->compiledNodes[step.node].handlersEnd)) {
+                    return true;
+                }
+            } else if (step.kind == CompiledStep::PARAMETER) {
+                if (segment.length()) {
+                    /* Parameter match */
+                    routeParameters.push(segment);
+                    if (executeCompiledHandlers(step.node, urlSegment + 1)) {
                         return true;
                     }
+                    routeParameters.pop();
                 }
-            } else if (p->name.length() && p->name[0] == ':' && segment.length()) {
-                /* Parameter match */
-                routeParameters.push(segment);
-                if (executeHandlers(p.get(), urlSegment + 1, userData)) {
-                    return true;
-                }
-                routeParameters.pop();
-            } else if (p->name == segment) {
+            } else {
                 /* Static match */
-                if (executeHandlers(p.get(), urlSegment + 1, userData)) {
+                uint32_t child = findStatic(step, segment);
+                if (child != UINT32_MAX && executeCompiledHandlers(child, urlSegment + 1)) {
                     return true;
                 }
             }
@@ -210,46 +436,91 @@ private:
         return false;
     }
 
-    /* Scans for one matching handler, returning the handler and its priority or UINT32_MAX for not found */
-    uint32_t findHandler(std::string method, std::string pattern, uint32_t priority) {
-        for (std::unique_ptr<Node> &node : root.children) {
-            if (method == node->name) {
-                setUrl(pattern);
-                Node *n = node.get();
-                for (int i = 0; !getUrlSegment(i).second; i++) {
-                    /* Go to next segment or quit */
-                    std::string segment = std::string(getUrlSegment(i).first);
-                    Node *next = nullptr;
-                    for (std::unique_ptr<Node> &child : n->children) {
-                        if (child->name == segment && child->isHighPriority == (priority == HIGH_PRIORITY)) {
-                            next = child.get();
-                            break;
-                        }
-                    }
-                    if (!next) {
-                        return UINT32_MAX;
-                    }
-                    n = next;
+    /* Collects the handlers executeCompiledHandlers would try, returns false if any of them would bind a parameter */
+    bool collectCompiledHandlers(uint32_t node, int urlSegment, std::vector<uint32_t> &handlers) {
+
+        auto [segment, isStop] = getUrlSegment(urlSegment);
+        const CompiledNode &compiledNode = table->compiledNodes[node];
+
+        if (isStop) {
+            handlers.insert(handlers.end(), table->compiledHandlers.begin() + compiledNode.handlersBegin, table->compiledHandlers.begin() + compiledNode.handlersEnd);
+            return true;
+        }
+
+        for (uint32_t i = compiledNode.stepsBegin, end = compiledNode.stepsEnd; i < end; i++) {
+            const CompiledStep &step = table->compiledSteps[i];
+            if (step.kind == CompiledStep::WILDCARD) {
+                handlers.insert(handlers.end(), table->compiledHandlers.begin() + table->compiledNodes[step.node].handlersBegin, table->compiledHandlers.begin() + table->compiledNodes[step.node].handlersEnd);
+            } else if (step.kind == CompiledStep::PARAMETER) {
+                if (segment.length()) {
+                    return false;
                 }
-                /* Seek for a priority match in the found node */
-                for (unsigned int i = 0; i < n->handlers.size(); i++) {
-                    if ((n->handlers[i] & ~HANDLER_MASK) == priority) {
-                        return n->handlers[i];
-                    }
+            } else {
+                uint32_t child = findStatic(step, segment);
+                if (child != UINT32_MAX && !collectCompiledHandlers(child, urlSegment + 1, handlers)) {
+                    return false;
                 }
+            }
+        }
+        return true;
+    }
+
+    static inline size_t cacheHash(std::string_view method, std::string_view url) {
+        /* FNV-1a */
+        size_t hash = 2166136261u;
+        for (char c : method) {
+            hash = (hash ^ (unsigned char) c) * 16777619u;
+        }
+        for (char c : url) {
+            hash = (hash ^ (unsigned char) c) * 16777619u;
+        }
+        return hash;
+    }
+
+    static inline bool cacheKeyEquals(std::string &key, std::string_view method, std::string_view url) {
+        return key.length() == method.length() + 1 + url.length()
+            && !memcmp(key.data(), method.data(), method.length())
+            && !memcmp(key.data() + method.length() + 1, url.data(), url.length());
+    }
+
+    /* Scans for one matching handler, returning the handler and its priority or UINT32_MAX for not found */
+    uint32_t findHandler(std::string_view method, std::string_view pattern, uint32_t priority) {
+        Node *n = findChild(&root, method, false);
+        if (!n) {
+            return UINT32_MAX;
+        }
+
+        setUrl(pattern);
+        for (int i = 0; !getUrlSegment(i).second; i++) {
+            /* Go to next segment or quit */
+            n = findChild(n, getUrlSegment(i).first, priority == HIGH_PRIORITY);
+            if (!n) {
                 return UINT32_MAX;
             }
         }
+        /* Seek for a priority match in the found node */
+        for (unsigned int i = 0; i < n->handlers.size(); i++) {
+            if ((n->handlers[i] & ~HANDLER_MASK) == priority) {
+                return n->handlers[i];
+            }
+        }
         return UINT32_MAX;
     }
 
 public:
-    HttpRouter() {
-        int p = 0;
-        for (std::string &method : upperCasedMethods) {
-            priority[method] = p++;
-        }
-    }
+    /* One entry of a route table added in bulk, methods are expected to outlive the call (usually literals) */
+    struct Route {
+        std::vector<std::string_view> methods;
+        std::string pattern;
+        MoveOnlyFunction<bool(HttpRouter *)> handler;
+        uint32_t priority = MEDIUM_PRIORITY;
+    };
+
+    HttpRouter() = default;
+
+    /* The child index refers to the root node by address */
+    HttpRouter(const HttpRouter &) = delete;
+    HttpRouter &operator=(const HttpRouter &) = delete;
 
     std::pair<int, std::string_view *> getParameters() {
         return {routeParameters.paramsTop, routeParameters.params};
@@ -259,17 +530,158 @@ public:
         return userData;
     }
 
+    /* Flattens the matching tree for route(). This is done automatically on first route after any change,
+     * but can be called up front to not have the first request pay for it */
+    void compile() {
+        compiledNodes.clear();
+        compiledSteps.clear();
+        compiledStatics.clear();
+        compiledHandlers.clear();
+        compiledJumpTables.clear();
+        compiledNames.clear();
+        compiledMethods.clear();
+
+        for (auto &p : root.children) {
+            compiledMethods.emplace_back(p->name, compileNode(p.get()));
+        }
+        isCompiled = true;
+
+        /* Invalidate the cache */
+        cacheGeneration++;
+    }
+
+    /* Moves all routes into an immutable, compiled table and routes with that from now on. Other routers
+     * (usually one per thread) can route with the same table via use(), while keeping their own URL state,
+     * parameters, cache and user data. Handlers are passed the router they are called from, so per-thread state
+     * still works, but they are called from many threads at once and must not capture state of any one of them.
+     * Routes added to this router afterwards are only used after use(nullptr).
+     * Returns nullptr, sharing nothing, if the router is bound to its thread */
+    std::shared_ptr<const HttpRouter> share() {
+        if (table != this) {
+            return sharedTable;
+        }
+
+        if (threadBound) {
+            return nullptr;
+        }
+
+        if (!isCompiled) {
+            compile();
+        }
+
+        std::shared_ptr<HttpRouter> shared = std::make_shared<HttpRouter>();
+        std::swap(shared->handlers, handlers);
+        std::swap(shared->nameArena, nameArena);
+        std::swap(shared->compiledNodes, compiledNodes);
+        std::swap(shared->compiledSteps, compiledSteps);
+        std::swap(shared->compiledStatics, compiledStatics);
+        std::swap(shared->compiledHandlers, compiledHandlers);
+        std::swap(shared->compiledJumpTables, compiledJumpTables);
+        std::swap(shared->compiledNames, compiledNames);
+        std::swap(shared->compiledMethods, compiledMethods);
+        shared->isCompiled = true;
+
+        /* Our tree refers to handlers and names we no longer have */
+        root.children.clear();
+        childIndex.clear();
+        isCompiled = false;
+
+        use(shared);
+        return shared;
+    }
+
+    /* Marks this router as having routes that only work on the thread that added them (such as ones capturing
+     * state of that thread), so that share() refuses to share them */
+    void bindToThread() {
+        threadBound = true;
+    }
+
+    /* Routes with a table made by share() instead of our own routes, or with our own again if nullptr */
+    void use(std::shared_ptr<const HttpRouter> shared) {
+        table = shared ? shared.get() : this;
+        sharedTable = std::move(shared);
+
+        /* Invalidate the cache */
+        cacheGeneration++;
+    }
+
+    /* Enables the route cache with room for (size rounded up to a power of two) URLs, 0 disables it */
+    void setCacheSize(unsigned int size) {
+        unsigned int slots = 1;
+        while (slots < size) {
+            slots <<= 1;
+        }
+        cache.clear();
+        cache.resize(size ? slots : 0);
+    }
+
+    /* Returns number of cache hits and misses */
+    std::pair<unsigned long long, unsigned long long> getCacheStats() {
+        return {cacheHits, cacheMisses};
+    }
+
+    /* Routes percent-decoded URLs with dot segments removed and repeated slashes collapsed, "/a/./b//%63" routes
+     * as "/a/b/c". Decoding comes first so that encoded dot segments are removed too, meaning "%2F" separates segments.
+     * URLs with malformed escapes are not routed. Parameters point into a copy valid for the duration of route() */
+    void setUrlNormalization(bool enabled) {
+        normalizesUrls = enabled;
+    }
+
     /* Fast path */
     bool route(std::string_view method, std::string_view url) {
+        if (!isCompiled && table == this) {
+            compile();
+        }
+
+        if (normalizesUrls) {
+            normalizedUrl.assign(url.data(), url.length());
+            char *begin = normalizedUrl.data(), *end = decodeUrl(begin, begin + normalizedUrl.length(), false);
+            if (!end) {
+                return false;
+            }
+            url = std::string_view(begin, (size_t) (normalizeUrlPath(begin, end) - begin));
+        }
+
         /* Reset url parsing cache */
         setUrl(url);
         routeParameters.reset();
 
+        /* Replay handlers of cached URLs */
+        CacheEntry *cacheEntry = nullptr;
+        if (cache.size()) {
+            cacheEntry = &cache[cacheHash(method, url) & (cache.size() - 1)];
+            if (cacheEntry->generation == cacheGeneration && cacheKeyEquals(cacheEntry->key, method, url)) {
+                if (cacheEntry->replayable) {
+                    cacheHits++;
+                    for (uint32_t handler : cacheEntry->handlers) {
+                        if (table->handlers[handler & HANDLER_MASK](this)) {
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+                /* Known to bind parameters, route it as usual */
+                cacheEntry = nullptr;
+            } else {
+                cacheMisses++;
+            }
+        }
+
         /* Begin by finding the method node */
-        for (auto &p : root.children) {
-            if (p->name == method) {
+        for (auto &[name, node] : table->compiledMethods) {
+            if (name == method) {
+                /* Fill the cache (the dry run stops at the first parameter bound) */
+                if (cacheEntry) {
+                    cacheEntry->key.assign(method.data(), method.length());
+                    cacheEntry->key.append(1, ' ');
+                    cacheEntry->key.append(url.data(), url.length());
+                    cacheEntry->generation = cacheGeneration;
+                    cacheEntry->handlers.clear();
+                    cacheEntry->replayable = collectCompiledHandlers(node, 0, cacheEntry->handlers);
+                }
+
                 /* Then route the url */
-                return executeHandlers(p.get(), 0, userData);
+                return executeCompiledHandlers(node, 0);
             }
         }
 
@@ -278,14 +690,16 @@ public:
     }
 
     /* Adds the corresponding entires in matching tree and handler list */
-    void add(std::vector<std::string> methods, std::string pattern, MoveOnlyFunction<bool(HttpRouter *)> &&handler, uint32_t priority = MEDIUM_PRIORITY) {
-        for (std::string method : methods) {
+    void add(const std::vector<std::string_view> &methods, std::string_view pattern, MoveOnlyFunction<bool(HttpRouter *)> &&handler, uint32_t priority = MEDIUM_PRIORITY) {
+        isCompiled = false;
+
+        for (std::string_view method : methods) {
             /* Lookup method */
             Node *node = getNode(&root, method, false);
             /* Iterate over all segments */
             setUrl(pattern);
             for (int i = 0; !getUrlSegment(i).second; i++) {
-                node = getNode(node, std::string(getUrlSegment(i).first), priority == HIGH_PRIORITY);
+                node = getNode(node, getUrlSegment(i).first, priority == HIGH_PRIORITY);
             }
             /* Insert handler in order sorted by priority (most significant 1 byte) */
             node->handlers.insert(std::upper_bound(node->handlers.begin(), node->handlers.end(), (uint32_t) (priority | handlers.size())), (uint32_t) (priority | handlers.size()));
@@ -301,6 +715,16 @@ public:
         }
     }
 
+    /* Adds a whole route table at once, same as adding every route in order but without growing as we go */
+    void add(std::vector<Route> &&routes) {
+        handlers.reserve(handlers.size() + routes.size());
+        childIndex.reserve(childIndex.size() + routes.size());
+
+        for (Route &route : routes) {
+            add(route.methods, route.pattern, std::move(route.handler), route.priority);
+        }
+    }
+
     bool cullNode(Node *parent, Node *node, uint32_t handler) {
         /* For all children */
         for (unsigned int i = 0; i < node->children.size(); ) {
@@ -327,6 +751,7 @@ public:
 
             /* If we have no children and no handlers, remove us from the parent->children list */
             if (!node->handlers.size() && !node->children.size()) {
+                childIndex.erase({parent, node->name, node->isHighPriority});
                 parent->children.erase(std::find_if(parent->children.begin(), parent->children.end(), [node](const std::unique_ptr<Node> &a) {
                     return a.get() == node;
                 }));
@@ -341,13 +766,15 @@ public:
     /* Removes ALL routes with the same handler as can be found with the given parameters.
      * Removing a wildcard is done by removing ONE OF the methods the wildcard would match with.
      * Example: If wildcard includes POST, GET, PUT, you can remove ALL THREE by removing GET. */
-    void remove(std::string method, std::string pattern, uint32_t priority) {
+    void remove(std::string_view method, std::string_view pattern, uint32_t priority) {
         uint32_t handler = findHandler(method, pattern, priority);
         if (handler == UINT32_MAX) {
             /* Not found or already removed, do nothing */
             return;
         }
 
+        isCompiled = false;
+
         /* Cull the entire tree */
         /* For all nodes in depth first tree traveral;
          * if node contains handler - remove the handler -
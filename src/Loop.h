@@ -192,6 +192,12 @@ public:
     void setSilent(bool silent) {
         ((LoopData *) us_loop_ext((us_loop_t *) this))->noMark = silent;
     }
+
+    /* Responses and messages up to this size are assembled in the cork buffer, larger ones are written
+     * straight off. Can be changed whenever we are not inside a corked section. Returns success */
+    bool setCorkBufferSize(unsigned int size) {
+        return ((LoopData *) us_loop_ext((us_loop_t *) this))->setCorkBufferSize(size);
+    }
 };
 
 /* Can be called from any thread to run the thread local loop */
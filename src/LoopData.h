@@ -27,6 +27,7 @@
 #include <cstdint>
 
 #include "PerMessageDeflate.h"
+#include "HttpCompression.h"
 #include "MoveOnlyFunction.h"
 
 struct us_timer_t;
@@ -51,11 +52,12 @@ public:
     }
 
     ~LoopData() {
-        /* If we have had App.ws called with compression we need to clear this */
-        if (zlibContext) {
-            delete zlibContext;
-            delete inflationStream;
-            delete deflationStream;
+        /* Created by App.ws with compression, or (only the context) by compressed HTTP responses */
+        delete zlibContext;
+        delete inflationStream;
+        delete deflationStream;
+        for (HttpCompressionStream *httpCompressionStream : httpCompressionStreams) {
+            delete httpCompressionStream;
         }
         delete [] corkBuffer;
     }
@@ -91,19 +93,34 @@ public:
     /* Be silent */
     bool noMark = false;
 
-    /* Good 16k for SSL perf. */
+    /* Good 16k for SSL perf, the default */
     static const unsigned int CORK_BUFFER_SIZE = 16 * 1024;
 
     /* Cork data */
+    unsigned int corkBufferSize = CORK_BUFFER_SIZE;
     char *corkBuffer = new char[CORK_BUFFER_SIZE];
     unsigned int corkOffset = 0;
     void *corkedSocket = nullptr;
 
+    /* Resizes the cork buffer, which must not be in use. Returns false if it is */
+    bool setCorkBufferSize(unsigned int size) {
+        if (corkedSocket || corkOffset || !size) {
+            return false;
+        }
+        delete [] corkBuffer;
+        corkBuffer = new char[size];
+        corkBufferSize = size;
+        return true;
+    }
+
     /* Per message deflate data */
     ZlibContext *zlibContext = nullptr;
     InflationStream *inflationStream = nullptr;
     DeflationStream *deflationStream = nullptr;
 
+    /* Shared by all HTTP responses compressed as a whole, by encoding */
+    HttpCompressionStream *httpCompressionStreams[ENCODING_BROTLI + 1] = {};
+
     us_timer_t *dateTimer;
 };
 
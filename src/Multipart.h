@@ -22,12 +22,15 @@
 #define UWS_MULTIPART_H
 
 #include "MessageParser.h"
+#include "Simd.h"
 
 #include <string_view>
+#include <string>
 #include <optional>
 #include <cstring>
 #include <utility>
 #include <cctype>
+#include <algorithm>
 
 namespace uWS {
 
@@ -226,6 +229,223 @@ namespace uWS {
         }
     };
 
+
+    /* Push-based parser for multipart bodies arriving in chunks (such as from HttpResponse::onData), in bounded memory.
+     * Part headers are collected (they are small), while part data is passed on as slices of the given chunks.
+     * Only a tail that may be the start of a boundary split over two chunks is held back, and passed on later as a copy */
+    struct StreamingMultipartParser {
+        /* Limit on the headers of one part, including line breaks */
+        static const unsigned int MAX_PART_HEADERS_SIZE = 4096;
+
+    private:
+        /* Parts are separated by CRLF, two hyphens and the 1 - 70 chars of boundary */
+        char delimiterBuffer[74];
+        std::string_view delimiter;
+
+        /* Tail of the previous chunk that is the start of a delimiter, always shorter than one.
+         * We begin with a line break so that a boundary at the very beginning of the body is found */
+        char carryBuffer[74] = {'\r', '\n'};
+        size_t carryLength = 2;
+
+        std::string headerBuffer;
+
+        enum State {
+            PREAMBLE,
+            HEADERS,
+            DATA,
+            DONE,
+            ERROR
+        } state = PREAMBLE;
+
+        /* Returns first delimiter in [p, end) or nullptr */
+        char *findDelimiter(char *p, char *end) {
+            if ((size_t) (end - p) < delimiter.length()) {
+                return nullptr;
+            }
+
+            /* Candidates have the first and last byte of the delimiter in place */
+            char *last = end - delimiter.length();
+            for (char *candidate = p; ; candidate++) {
+                candidate = simd::Native::findPair(candidate, last + 1, '\r', delimiter.back(), delimiter.length() - 1);
+                if (candidate > last) {
+                    return nullptr;
+                }
+                if (!memcmp(candidate + 1, delimiter.data() + 1, delimiter.length() - 2)) {
+                    return candidate;
+                }
+            }
+        }
+
+        /* Passes on data of the current part, while the preamble is thrown away */
+        template <typename D>
+        void emit(std::string_view data, bool last, D &onPartData) {
+            if (state == DATA && (data.length() || last)) {
+                onPartData(data, last);
+            }
+        }
+
+        template <typename D>
+        char *consumeData(char *p, char *end, D &onPartData) {
+            if (carryLength) {
+                /* Does a delimiter begin in what we held back? */
+                char bridge[2 * sizeof(carryBuffer)];
+                size_t fromChunk = std::min<size_t>((size_t) (end - p), delimiter.length() - 1);
+                memcpy(bridge, carryBuffer, carryLength);
+                memcpy(bridge + carryLength, p, fromChunk);
+                size_t bridgeLength = carryLength + fromChunk;
+
+                for (size_t i = 0; i < carryLength; i++) {
+                    size_t compared = std::min<size_t>(bridgeLength - i, delimiter.length());
+                    if (memcmp(bridge + i, delimiter.data(), compared)) {
+                        continue;
+                    }
+
+                    if (compared == delimiter.length()) {
+                        emit(std::string_view(carryBuffer, i), true, onPartData);
+                        char *next = p + (i + delimiter.length() - carryLength);
+                        carryLength = 0;
+                        state = HEADERS;
+                        headerBuffer.clear();
+                        return next;
+                    }
+
+                    /* Still only the start of one, so this chunk was shorter than a delimiter */
+                    emit(std::string_view(carryBuffer, i), false, onPartData);
+                    memcpy(carryBuffer, bridge + i, compared);
+                    carryLength = compared;
+                    return end;
+                }
+
+                emit(std::string_view(carryBuffer, carryLength), false, onPartData);
+                carryLength = 0;
+            }
+
+            char *found = findDelimiter(p, end);
+            if (found) {
+                emit(std::string_view(p, (size_t) (found - p)), true, onPartData);
+                state = HEADERS;
+                headerBuffer.clear();
+                return found + delimiter.length();
+            }
+
+            /* Hold back a tail that is the start of a delimiter */
+            char *hold = end - std::min<size_t>((size_t) (end - p), delimiter.length() - 1);
+            while ((hold = (char *) memchr(hold, '\r', (size_t) (end - hold))) && memcmp(hold, delimiter.data(), (size_t) (end - hold))) {
+                hold++;
+            }
+            if (!hold) {
+                hold = end;
+            }
+
+            emit(std::string_view(p, (size_t) (hold - p)), false, onPartData);
+            memcpy(carryBuffer, hold, (size_t) (end - hold));
+            carryLength = (size_t) (end - hold);
+            return end;
+        }
+
+        template <typename H>
+        char *consumeHeaders(char *p, char *end, H &onPart) {
+            /* The end of headers may span what we have and what we append */
+            size_t searchFrom = headerBuffer.length() > 3 ? headerBuffer.length() - 3 : 0;
+            size_t appended = std::min<size_t>((size_t) (end - p), MAX_PART_HEADERS_SIZE - headerBuffer.length());
+            headerBuffer.append(p, appended);
+
+            /* The last delimiter is followed by two hyphens, anything after that is an epilogue we ignore */
+            if (headerBuffer.length() >= 2 && headerBuffer[0] == '-' && headerBuffer[1] == '-') {
+                state = DONE;
+                return end;
+            }
+
+            /* Otherwise it ends its line */
+            std::string_view lineEnd = std::string_view(headerBuffer).substr(0, 2);
+            if (lineEnd != std::string_view("\r\n", lineEnd.length()) && lineEnd != "-") {
+                state = ERROR;
+                return end;
+            }
+
+            size_t headersEnd = headerBuffer.find("\r\n\r\n", searchFrom);
+            if (headersEnd == std::string::npos) {
+                if (headerBuffer.length() == MAX_PART_HEADERS_SIZE) {
+                    state = ERROR;
+                }
+                return p + appended;
+            }
+            headersEnd += 4;
+
+            /* Skip the line break of the delimiter, the part must have nothing but headers before the empty line */
+            std::pair<std::string_view, std::string_view> headers[MAX_HEADERS + 1];
+            if (getHeaders(headerBuffer.data() + 2, headerBuffer.data() + headersEnd, headers) != headersEnd - 2) {
+                state = ERROR;
+                return end;
+            }
+
+            onPart(headers);
+            state = DATA;
+
+            /* What we appended past the headers is data */
+            return p + appended - (headerBuffer.length() - headersEnd);
+        }
+
+    public:
+        /* Construct the parser based on contentType (reads boundary parameter) */
+        StreamingMultipartParser(std::string_view contentType) {
+            if (contentType.length() < 10 || contentType.substr(0, 10) != "multipart/") {
+                return;
+            }
+
+            ParameterParser pp(contentType);
+            while (true) {
+                auto [key, value] = pp.getKeyValue();
+                if (!key.length()) {
+                    return;
+                }
+
+                if (key == "boundary") {
+                    /* Boundary must be less than or equal to 70 chars yet 1 char or longer */
+                    if (!value.length() || value.length() > 70) {
+                        return;
+                    }
+
+                    memcpy(delimiterBuffer, "\r\n--", 4);
+                    memcpy(delimiterBuffer + 4, value.data(), value.length());
+                    delimiter = {delimiterBuffer, value.length() + 4};
+                    return;
+                }
+            }
+        }
+
+        /* Is this a valid multipart request, that has not failed parsing? */
+        bool isValid() {
+            return delimiter.length() && state != ERROR;
+        }
+
+        /* Have we seen the last boundary? A body ending before that was cut short */
+        bool isDone() {
+            return state == DONE;
+        }
+
+        /* Consumes the next chunk of body, calling onPart(headers) as each part begins and onPartData(data, last)
+         * with its data, in one or many slices. Headers are lower-cased and terminated like with MultipartParser,
+         * headers and data are only valid during the call. Returns false if the body is malformed */
+        template <typename H, typename D>
+        bool consume(std::string_view chunk, H &&onPart, D &&onPartData) {
+            if (!delimiter.length()) {
+                return false;
+            }
+
+            char *p = (char *) chunk.data(), *end = p + chunk.length();
+            while (p != end && (state == PREAMBLE || state == HEADERS || state == DATA)) {
+                if (state == HEADERS) {
+                    p = consumeHeaders(p, end, onPart);
+                } else {
+                    p = consumeData(p, end, onPartData);
+                }
+            }
+
+            return state != ERROR;
+        }
+    };
+
 }
 
 #endif
@@ -0,0 +1,101 @@
+/*
+ * Authored by Alex Hultman, 2018-2023.
+ * Intellectual property of third-party.
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *     http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* A PreparedResponse is a complete response (status line, headers and body) rendered once up front,
+ * for static endpoints such as health checks. Sending it is a copy of the rendered bytes with the
+ * current date written over its Date slot, so one PreparedResponse can be shared by all threads */
+
+#ifndef UWS_PREPAREDRESPONSE_H
+#define UWS_PREPAREDRESPONSE_H
+
+#include <string>
+#include <string_view>
+
+#include "Utilities.h"
+
+namespace uWS {
+
+struct PreparedResponse {
+    template <bool> friend struct HttpResponse;
+private:
+    /* The whole response, once end is called */
+    std::string rendered;
+    std::string status = "200 OK";
+    std::string headers;
+
+    /* Where the 29 byte date goes, where the mark header is (so that it can be left out) and where the body starts */
+    size_t dateOffset = 0, markOffset = 0, markLength = 0, bodyOffset = 0;
+
+public:
+    /* Length of an HTTP date, such as "Sun, 06 Nov 1994 08:49:37 GMT" */
+    static const size_t DATE_LENGTH = 29;
+
+    PreparedResponse &writeStatus(std::string_view status) {
+        this->status = status;
+        return *this;
+    }
+
+    PreparedResponse &writeHeader(std::string_view key, std::string_view value) {
+        headers.append(key).append(": ").append(value).append("\r\n");
+        return *this;
+    }
+
+    /* Renders the response with the given body. Nothing can be written after this */
+    PreparedResponse &end(std::string_view body = {}) {
+        rendered.assign("HTTP/1.1 ").append(status).append("\r\n").append(headers);
+
+        /* Date is always written, the slot is filled in when sending */
+        rendered.append("Date: ");
+        dateOffset = rendered.length();
+        rendered.append(DATE_LENGTH, ' ').append("\r\n");
+
+        markOffset = rendered.length();
+#ifndef UWS_HTTPRESPONSE_NO_WRITEMARK
+        rendered.append("uWebSockets: 20\r\n");
+#endif
+        markLength = rendered.length() - markOffset;
+
+        char length[20];
+        rendered.append("Content-Length: ").append(length, (size_t) utils::u64toa(body.length(), length)).append("\r\n\r\n");
+
+        bodyOffset = rendered.length();
+        rendered.append(body);
+        return *this;
+    }
+
+    /* The rendered response, with blanks for the date */
+    std::string_view data() const {
+        return rendered;
+    }
+
+    /* The status and headers as given, used when a response has already been started */
+    std::string_view getStatus() const {
+        return status;
+    }
+
+    std::string_view getHeaders() const {
+        return headers;
+    }
+
+    std::string_view getBody() const {
+        return std::string_view(rendered).substr(bodyOffset);
+    }
+};
+
+}
+
+#endif // UWS_PREPAREDRESPONSE_H
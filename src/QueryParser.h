@@ -21,9 +21,69 @@
 #define UWS_QUERYPARSER_H
 
 #include <string_view>
+#include <cstring>
+
+#include "Simd.h"
+#include "UrlDecoder.h"
 
 namespace uWS {
 
+    /* Splits a raw query (without the initial '?') into key, value pairs and percent-decodes both ('+' being a space)
+     * in one pass, calling handler for each. Decoded pairs are packed into out as we go, which holds at least end - begin
+     * bytes. Only when out is begin is the query decoded in place.
+     * Statements with an empty key or a malformed escape in their key are skipped,
+     * a statement without '=' or with a malformed escape in its value gets a null value */
+    template <typename F>
+    static inline void decodeQuery(char *begin, char *end, char *out, F &&handler) {
+        char *key = out, *value = nullptr;
+        bool malformedKey = false, malformedValue = false;
+
+        for (char *p = begin; ; ) {
+            /* Everything up to the next delimiter is moved as one run */
+            char *delimiter = simd::Native::findQueryDelimiter(p, end);
+            if (out != p) {
+                memmove(out, p, (size_t) (delimiter - p));
+            }
+            out += delimiter - p;
+            p = delimiter + 1;
+
+            if (delimiter == end || *delimiter == '&') {
+                /* End of statement, we can't have a value without a key */
+                char *keyEnd = value ? value : out;
+                if (!malformedKey && keyEnd != key) {
+                    handler(std::string_view(key, (size_t) (keyEnd - key)), (!value || malformedValue) ? std::string_view(nullptr, 0) : std::string_view(value, (size_t) (out - value)));
+                }
+
+                if (delimiter == end) {
+                    return;
+                }
+                key = out;
+                value = nullptr;
+                malformedKey = malformedValue = false;
+            } else if (*delimiter == '=') {
+                if (value) {
+                    /* Values may hold '=' themselves */
+                    *(out++) = '=';
+                } else {
+                    value = out;
+                }
+            } else if (*delimiter == '+') {
+                *(out++) = ' ';
+            } else {
+                /* Do we have two hex digits? */
+                int hex1 = end - delimiter < 3 ? -1 : hexValue(delimiter[1]);
+                int hex2 = hex1 < 0 ? -1 : hexValue(delimiter[2]);
+                if (hex2 < 0) {
+                    (value ? malformedValue : malformedKey) = true;
+                    continue;
+                }
+
+                *((unsigned char *) out++) = (unsigned char) (hex1 * 16 + hex2);
+                p = delimiter + 3;
+            }
+        }
+    }
+
     /* Takes raw query including initial '?' sign. Will inplace decode, so input will mutate */
     static inline std::string_view getDecodedQueryValue(std::string_view key, std::string_view rawQuery) {
 
@@ -55,52 +115,19 @@ namespace uWS {
                         /* Decode value inplace, put null at end if before length of original */
                         char *in = (char *) statementValue.data();
 
-                        /* Write offset */
-                        unsigned int out = 0;
-
-                        /* Walk over all chars until end or null char, decoding in place */
-                        for (unsigned int i = 0; i < statementValue.length() && in[i]; i++) {
-                                /* Only bother with '%' */
-                                if (in[i] == '%') {
-                                    /* Do we have enough data for two bytes hex? */
-                                    if (i + 2 >= statementValue.length()) {
-                                        return {};
-                                    }
-
-                                    /* Two bytes hex */
-                                    int hex1 = in[i + 1] - '0';
-                                    if (hex1 > 9) {
-                                        hex1 &= 223;
-                                        hex1 -= 7;
-                                    }
-
-                                    int hex2 = in[i + 2] - '0';
-                                    if (hex2 > 9) {
-                                        hex2 &= 223;
-                                        hex2 -= 7;
-                                    }
-
-                                    *((unsigned char *) &in[out]) = (unsigned char) (hex1 * 16 + hex2);
-                                    i += 2;
-                                } else {
-                                    /* Is this even a rule? */
-                                    if (in[i] == '+') {
-                                        in[out] = ' ';
-                                    } else {
-                                        in[out] = in[i];
-                                    }
-                                }
-
-                                /* We always only write one char */
-                                out++;
+                        /* A previous call may already have decoded this value, stop at its null */
+                        char *end = (char *) memchr(in, 0, statementValue.length());
+                        char *out = decodeUrl(in, end ? end : in + statementValue.length(), true);
+                        if (!out) {
+                            return {};
                         }
 
                         /* If decoded string is shorter than original, put null char to stop next read */
-                        if (out < statementValue.length()) {
-                            in[out] = 0;
+                        if (out < in + statementValue.length()) {
+                            *out = 0;
                         }
 
-                        return statementValue.substr(0, out);
+                        return statementValue.substr(0, (size_t) (out - in));
                     }
                 } else {
                     /* This querystring is invalid, cannot parse it */
@@ -0,0 +1,349 @@
+/*
+ * Authored by Alex Hultman, 2018-2023.
+ * Intellectual property of third-party.
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *     http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UWS_SIMD_H
+#define UWS_SIMD_H
+
+/* Byte scanning kernels shared by the parsers. SSE2 and NEON are baseline on x86-64 and AArch64,
+ * AVX2 is selected at runtime. Define UWS_NO_SIMD to build with the scalar kernels only. */
+
+#include <cstdint>
+#include <cstring>
+
+#if !defined(UWS_NO_SIMD) && (defined(__GNUC__) || defined(__clang__))
+#if defined(__x86_64__)
+#define UWS_SIMD_SSE2
+#define UWS_SIMD_AVX2
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define UWS_SIMD_NEON
+#include <arm_neon.h>
+#endif
+#endif
+
+#ifdef UWS_SIMD_AVX2
+/* Functions calling into Avx2 kernels must be compiled for AVX2 and should have them inlined */
+#define UWS_SIMD_AVX2_FUNCTION __attribute__((target("avx2"), flatten))
+#endif
+
+namespace uWS {
+namespace simd {
+
+/* Returns true if the CPU we run on supports AVX2 (checked once) */
+inline bool hasAvx2() {
+#ifdef UWS_SIMD_AVX2
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+#else
+    return false;
+#endif
+}
+
+/* All kernels scan [p, end), but not all of them stop reading at end. Token scans (lowerCaseToken, findCarriageReturn)
+ * rely on the buffer being fenced (terminated) by a stop byte at end, just like the scalar HTTP parser, and read it.
+ * findPair reads distance bytes past every candidate, so up to end - 1 + distance. The others never read at or past end. */
+
+struct Scalar {
+    /* Lower-cases a header field name in place, stopping at ':' or any byte below 33 */
+    static inline char *lowerCaseToken(char *p, char *) {
+        for (; (*p != ':') & (*(unsigned char *)p > 32); *(p++) |= 32);
+        return p;
+    }
+
+    /* Returns first '\r' in [p, end) or nullptr */
+    static inline char *findCarriageReturn(char *p, char *end) {
+        uint64_t mask = *(uint64_t *)"\r\r\r\r\r\r\r\r";
+        if (p <= end - 8) {
+            for (; p <= end - 8; p += 8) {
+                uint64_t val = *(uint64_t *)p ^ mask;
+                if ((val + 0xfefefefefefefeffull) & (~val & 0x8080808080808080ull)) {
+                    break;
+                }
+            }
+        }
+
+        for (; p < end; p++) {
+            if (*(unsigned char *)p == '\r') {
+                return p;
+            }
+        }
+
+        return nullptr;
+    }
+
+    /* Returns first '&', '=', '%' or '+' in [p, end) or end */
+    static inline char *findQueryDelimiter(char *p, char *end) {
+        for (; end - p >= 8; p += 8) {
+            uint64_t word;
+            memcpy(&word, p, 8);
+            auto hasByte = [word](uint64_t mask) {
+                uint64_t val = word ^ mask;
+                return (val + 0xfefefefefefefeffull) & ~val & 0x8080808080808080ull;
+            };
+            if (hasByte(0x2626262626262626ull) | hasByte(0x3d3d3d3d3d3d3d3dull) | hasByte(0x2525252525252525ull) | hasByte(0x2b2b2b2b2b2b2b2bull)) {
+                break;
+            }
+        }
+
+        for (; p < end && *p != '&' && *p != '=' && *p != '%' && *p != '+'; p++);
+        return p;
+    }
+
+    /* Returns first a or b in [p, end) or end */
+    static inline char *findEither(char *p, char *end, char a, char b) {
+        for (; p < end && *p != a && *p != b; p++);
+        return p;
+    }
+
+    /* Returns first '/' in [p, end) followed by '/' or '.' (a possibly non-normal path segment) or end */
+    static inline char *findDotSegment(char *p, char *end) {
+        for (; end - p >= 2; p++) {
+            if (p[0] == '/' && (p[1] == '/' || p[1] == '.')) {
+                return p;
+            }
+        }
+        return end;
+    }
+
+    /* Returns first q in [p, end) with q[0] == a and q[distance] == b, or end. Reads up to end + distance.
+     * Comparing two bytes of a needle at once (usually its first and last) leaves few false candidates */
+    static inline char *findPair(char *p, char *end, char a, char b, size_t distance) {
+        for (; p < end && (p[0] != a || p[distance] != b); p++);
+        return p;
+    }
+};
+
+#ifdef UWS_SIMD_SSE2
+struct Sse2 {
+    static inline char *lowerCaseToken(char *p, char *end) {
+        const __m128i colon = _mm_set1_epi8(':'), space = _mm_set1_epi8(' ');
+        const __m128i index = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+        for (; end - p >= 16; p += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *) p);
+            /* Unsigned v <= 32 is min(v, 32) == v */
+            __m128i stop = _mm_or_si128(_mm_cmpeq_epi8(v, colon), _mm_cmpeq_epi8(_mm_min_epu8(v, space), v));
+            unsigned int mask = (unsigned int) _mm_movemask_epi8(stop);
+            if (mask) {
+                /* Only lower-case what comes before the stop byte, the rest is written back untouched */
+                int n = __builtin_ctz(mask);
+                __m128i before = _mm_cmpgt_epi8(_mm_set1_epi8((char) n), index);
+                _mm_storeu_si128((__m128i *) p, _mm_or_si128(v, _mm_and_si128(before, space)));
+                return p + n;
+            }
+            _mm_storeu_si128((__m128i *) p, _mm_or_si128(v, space));
+        }
+        return Scalar::lowerCaseToken(p, end);
+    }
+
+    static inline char *findCarriageReturn(char *p, char *end) {
+        const __m128i cr = _mm_set1_epi8('\r');
+        for (; end - p >= 16; p += 16) {
+            unsigned int mask = (unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) p), cr));
+            if (mask) {
+                return p + __builtin_ctz(mask);
+            }
+        }
+        return Scalar::findCarriageReturn(p, end);
+    }
+
+    static inline char *findQueryDelimiter(char *p, char *end) {
+        const __m128i ampersand = _mm_set1_epi8('&'), equals = _mm_set1_epi8('='), percent = _mm_set1_epi8('%'), plus = _mm_set1_epi8('+');
+        for (; end - p >= 16; p += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *) p);
+            __m128i found = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, ampersand), _mm_cmpeq_epi8(v, equals)), _mm_or_si128(_mm_cmpeq_epi8(v, percent), _mm_cmpeq_epi8(v, plus)));
+            unsigned int mask = (unsigned int) _mm_movemask_epi8(found);
+            if (mask) {
+                return p + __builtin_ctz(mask);
+            }
+        }
+        return Scalar::findQueryDelimiter(p, end);
+    }
+
+    static inline char *findEither(char *p, char *end, char a, char b) {
+        const __m128i va = _mm_set1_epi8(a), vb = _mm_set1_epi8(b);
+        for (; end - p >= 16; p += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *) p);
+            unsigned int mask = (unsigned int) _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)));
+            if (mask) {
+                return p + __builtin_ctz(mask);
+            }
+        }
+        return Scalar::findEither(p, end, a, b);
+    }
+
+    static inline char *findDotSegment(char *p, char *end) {
+        const __m128i slash = _mm_set1_epi8('/'), dot = _mm_set1_epi8('.');
+        /* Compares every byte with the one following it, so we need one byte more than we step */
+        for (; end - p >= 17; p += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *) p), next = _mm_loadu_si128((const __m128i *) (p + 1));
+            __m128i found = _mm_and_si128(_mm_cmpeq_epi8(v, slash), _mm_or_si128(_mm_cmpeq_epi8(next, slash), _mm_cmpeq_epi8(next, dot)));
+            unsigned int mask = (unsigned int) _mm_movemask_epi8(found);
+            if (mask) {
+                return p + __builtin_ctz(mask);
+            }
+        }
+        return Scalar::findDotSegment(p, end);
+    }
+
+    static inline char *findPair(char *p, char *end, char a, char b, size_t distance) {
+        const __m128i va = _mm_set1_epi8(a), vb = _mm_set1_epi8(b);
+        for (; end - p >= 16; p += 16) {
+            __m128i first = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) p), va);
+            __m128i second = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (p + distance)), vb);
+            unsigned int mask = (unsigned int) _mm_movemask_epi8(_mm_and_si128(first, second));
+            if (mask) {
+                return p + __builtin_ctz(mask);
+            }
+        }
+        return Scalar::findPair(p, end, a, b, distance);
+    }
+};
+
+/* Header scans only, which HttpParser dispatches to at runtime. Everything else scans with Native */
+struct Avx2 {
+    __attribute__((target("avx2"))) static inline char *lowerCaseToken(char *p, char *end) {
+        const __m256i colon = _mm256_set1_epi8(':'), space = _mm256_set1_epi8(' ');
+        const __m256i index = _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+            16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31);
+        for (; end - p >= 32; p += 32) {
+            __m256i v = _mm256_loadu_si256((const __m256i *) p);
+            __m256i stop = _mm256_or_si256(_mm256_cmpeq_epi8(v, colon), _mm256_cmpeq_epi8(_mm256_min_epu8(v, space), v));
+            unsigned int mask = (unsigned int) _mm256_movemask_epi8(stop);
+            if (mask) {
+                int n = __builtin_ctz(mask);
+                __m256i before = _mm256_cmpgt_epi8(_mm256_set1_epi8((char) n), index);
+                _mm256_storeu_si256((__m256i *) p, _mm256_or_si256(v, _mm256_and_si256(before, space)));
+                return p + n;
+            }
+            _mm256_storeu_si256((__m256i *) p, _mm256_or_si256(v, space));
+        }
+        /* Short tails are common (most header names are short) so take them 16 at a time */
+        return Sse2::lowerCaseToken(p, end);
+    }
+
+    __attribute__((target("avx2"))) static inline char *findCarriageReturn(char *p, char *end) {
+        const __m256i cr = _mm256_set1_epi8('\r');
+        for (; end - p >= 32; p += 32) {
+            unsigned int mask = (unsigned int) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *) p), cr));
+            if (mask) {
+                return p + __builtin_ctz(mask);
+            }
+        }
+        return Sse2::findCarriageReturn(p, end);
+    }
+};
+#endif
+
+#ifdef UWS_SIMD_NEON
+struct Neon {
+    /* NEON has no movemask; narrowing gives us 4 bits per byte instead */
+    static inline uint64_t mask(uint8x16_t v) {
+        return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(v), 4)), 0);
+    }
+
+    static inline char *lowerCaseToken(char *p, char *end) {
+        static const uint8_t indices[16] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+        const uint8x16_t colon = vdupq_n_u8(':'), space = vdupq_n_u8(' '), index = vld1q_u8(indices);
+        for (; end - p >= 16; p += 16) {
+            uint8x16_t v = vld1q_u8((const uint8_t *) p);
+            uint64_t stop = mask(vorrq_u8(vceqq_u8(v, colon), vcleq_u8(v, space)));
+            if (stop) {
+                unsigned int n = (unsigned int) __builtin_ctzll(stop) >> 2;
+                uint8x16_t before = vcltq_u8(index, vdupq_n_u8((uint8_t) n));
+                vst1q_u8((uint8_t *) p, vorrq_u8(v, vandq_u8(before, space)));
+                return p + n;
+            }
+            vst1q_u8((uint8_t *) p, vorrq_u8(v, space));
+        }
+        return Scalar::lowerCaseToken(p, end);
+    }
+
+    static inline char *findCarriageReturn(char *p, char *end) {
+        const uint8x16_t cr = vdupq_n_u8('\r');
+        for (; end - p >= 16; p += 16) {
+            uint64_t found = mask(vceqq_u8(vld1q_u8((const uint8_t *) p), cr));
+            if (found) {
+                return p + (__builtin_ctzll(found) >> 2);
+            }
+        }
+        return Scalar::findCarriageReturn(p, end);
+    }
+
+    static inline char *findQueryDelimiter(char *p, char *end) {
+        const uint8x16_t ampersand = vdupq_n_u8('&'), equals = vdupq_n_u8('='), percent = vdupq_n_u8('%'), plus = vdupq_n_u8('+');
+        for (; end - p >= 16; p += 16) {
+            uint8x16_t v = vld1q_u8((const uint8_t *) p);
+            uint64_t found = mask(vorrq_u8(vorrq_u8(vceqq_u8(v, ampersand), vceqq_u8(v, equals)), vorrq_u8(vceqq_u8(v, percent), vceqq_u8(v, plus))));
+            if (found) {
+                return p + (__builtin_ctzll(found) >> 2);
+            }
+        }
+        return Scalar::findQueryDelimiter(p, end);
+    }
+
+    static inline char *findEither(char *p, char *end, char a, char b) {
+        const uint8x16_t va = vdupq_n_u8((uint8_t) a), vb = vdupq_n_u8((uint8_t) b);
+        for (; end - p >= 16; p += 16) {
+            uint8x16_t v = vld1q_u8((const uint8_t *) p);
+            uint64_t found = mask(vorrq_u8(vceqq_u8(v, va), vceqq_u8(v, vb)));
+            if (found) {
+                return p + (__builtin_ctzll(found) >> 2);
+            }
+        }
+        return Scalar::findEither(p, end, a, b);
+    }
+
+    static inline char *findDotSegment(char *p, char *end) {
+        const uint8x16_t slash = vdupq_n_u8('/'), dot = vdupq_n_u8('.');
+        for (; end - p >= 17; p += 16) {
+            uint8x16_t v = vld1q_u8((const uint8_t *) p), next = vld1q_u8((const uint8_t *) (p + 1));
+            uint64_t found = mask(vandq_u8(vceqq_u8(v, slash), vorrq_u8(vceqq_u8(next, slash), vceqq_u8(next, dot))));
+            if (found) {
+                return p + (__builtin_ctzll(found) >> 2);
+            }
+        }
+        return Scalar::findDotSegment(p, end);
+    }
+
+    static inline char *findPair(char *p, char *end, char a, char b, size_t distance) {
+        const uint8x16_t va = vdupq_n_u8((uint8_t) a), vb = vdupq_n_u8((uint8_t) b);
+        for (; end - p >= 16; p += 16) {
+            uint8x16_t first = vceqq_u8(vld1q_u8((const uint8_t *) p), va);
+            uint8x16_t second = vceqq_u8(vld1q_u8((const uint8_t *) (p + distance)), vb);
+            uint64_t found = mask(vandq_u8(first, second));
+            if (found) {
+                return p + (__builtin_ctzll(found) >> 2);
+            }
+        }
+        return Scalar::findPair(p, end, a, b, distance);
+    }
+};
+#endif
+
+/* The best kernels available without runtime dispatch */
+#if defined(UWS_SIMD_SSE2)
+typedef Sse2 Native;
+#elif defined(UWS_SIMD_NEON)
+typedef Neon Native;
+#else
+typedef Scalar Native;
+#endif
+
+}
+}
+
+#endif // UWS_SIMD_H
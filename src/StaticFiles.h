@@ -0,0 +1,392 @@
+/*
+ * Authored by Alex Hultman, 2018-2023.
+ * Intellectual property of third-party.
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *     http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* A handler serving files below a root directory, mounted on a wildcard route under /static as uWS::StaticFiles("public", "/static").
+ * Files are kept in an LRU cache along with their ETag, Last-Modified and Content-Type. Small files are held in memory
+ * as a PreparedResponse, larger ones as an open fd sent with sendFile. Precompressed ".gz" and ".br" siblings are served
+ * in place of their original to clients accepting them. Conditional requests are answered from the cache,
+ * and cached files are only checked for changes once every revalidation interval. Copies share the cache, which is
+ * locked so that the handler can be used with routes shared by many threads. Like sendFile, this is safe from SIGPIPE */
+
+#ifndef UWS_STATICFILES_H
+#define UWS_STATICFILES_H
+
+#ifndef _WIN32
+
+#include <string>
+#include <string_view>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <ctime>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "PreparedResponse.h"
+#include "HttpRange.h"
+#include "HttpCompression.h"
+#include "UrlDecoder.h"
+#include "WellKnownHeaders.h"
+#include "Utilities.h"
+
+namespace uWS {
+
+struct StaticFile {
+    /* Only open for files not held in memory */
+    int fd = -1;
+    uintmax_t size = 0;
+
+    /* What we compare against when revalidating */
+    time_t modified = 0;
+    ino_t inode = 0;
+    std::chrono::steady_clock::time_point validated;
+
+    std::string_view contentType;
+    std::string etag, lastModified;
+
+    /* The whole 200 response, for files held in memory */
+    bool inMemory = false;
+    PreparedResponse response;
+
+    /* Precompressed siblings ("file.gz", "file.br") are found along with their original and served in its place */
+    HttpEncoding encoding = ENCODING_IDENTITY;
+    std::shared_ptr<StaticFile> gzip, brotli;
+
+    /* Whether there are other representations, which caches need to know */
+    bool varies = false;
+
+    ~StaticFile() {
+        if (fd != -1) {
+            close(fd);
+        }
+    }
+};
+
+struct StaticFiles {
+private:
+    struct Cache {
+        std::string root, prefix;
+        size_t maxFiles;
+        uintmax_t maxInMemorySize;
+        std::chrono::seconds revalidateInterval;
+
+        /* Most recently used first */
+        std::mutex mutex;
+        std::list<std::pair<std::string, std::shared_ptr<StaticFile>>> files;
+        std::unordered_map<std::string_view, decltype(files)::iterator> index;
+    };
+    std::shared_ptr<Cache> cache;
+
+    static std::string_view getContentType(std::string_view path) {
+        static const std::pair<std::string_view, std::string_view> contentTypes[] = {
+            {".html", "text/html; charset=utf-8"}, {".css", "text/css; charset=utf-8"}, {".js", "text/javascript; charset=utf-8"},
+            {".mjs", "text/javascript; charset=utf-8"}, {".json", "application/json"}, {".txt", "text/plain; charset=utf-8"},
+            {".svg", "image/svg+xml"}, {".png", "image/png"}, {".jpg", "image/jpeg"}, {".jpeg", "image/jpeg"}, {".gif", "image/gif"},
+            {".webp", "image/webp"}, {".ico", "image/x-icon"}, {".woff", "font/woff"}, {".woff2", "font/woff2"},
+            {".wasm", "application/wasm"}, {".pdf", "application/pdf"}, {".xml", "application/xml"}, {".mp4", "video/mp4"}
+        };
+
+        size_t dot = path.rfind('.');
+        if (dot != std::string_view::npos && path.find('/', dot) == std::string_view::npos) {
+            std::string_view extension = path.substr(dot);
+            for (auto &[candidate, contentType] : contentTypes) {
+                if (candidate.length() == extension.length() && std::equal(candidate.begin(), candidate.end(), extension.begin(), [](char a, char b) {
+                    return a == (b | 32);
+                })) {
+                    return contentType;
+                }
+            }
+        }
+        return "application/octet-stream";
+    }
+
+    /* Formats like the Date header, "Sun, 06 Nov 1994 08:49:37 GMT" */
+    static std::string formatHttpDate(time_t time) {
+        static const char wday_name[][4] = {
+            "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"
+        };
+        static const char mon_name[][4] = {
+            "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+            "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+        };
+        struct tm tstruct = {};
+        gmtime_r(&time, &tstruct);
+        char date[32];
+        snprintf(date, 32, "%.3s, %.2u %.3s %.4u %.2u:%.2u:%.2u GMT",
+            wday_name[tstruct.tm_wday],
+            tstruct.tm_mday % 99,
+            mon_name[tstruct.tm_mon],
+            (1900 + tstruct.tm_year) % 9999,
+            tstruct.tm_hour % 99,
+            tstruct.tm_min % 99,
+            tstruct.tm_sec % 99);
+        return date;
+    }
+
+    template <class Response>
+    static void writeHeaders(Response &response, const StaticFile &file) {
+        response.writeHeader("Content-Type", file.contentType);
+        if (file.encoding) {
+            response.writeHeader("Content-Encoding", getEncodingName(file.encoding));
+        }
+        if (file.varies) {
+            response.writeHeader("Vary", "Accept-Encoding");
+        }
+        response.writeHeader("ETag", file.etag);
+        response.writeHeader("Last-Modified", file.lastModified);
+        response.writeHeader("Accept-Ranges", "bytes");
+    }
+
+    /* Opens and describes a regular file along with its precompressed siblings, reading it into memory if small enough */
+    std::shared_ptr<StaticFile> load(const std::string &path, std::string_view contentType, HttpEncoding encoding = ENCODING_IDENTITY) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1) {
+            return nullptr;
+        }
+
+        std::shared_ptr<StaticFile> file = std::make_shared<StaticFile>();
+        file->fd = fd;
+
+        struct stat st;
+        if (fstat(fd, &st) || !S_ISREG(st.st_mode)) {
+            return nullptr;
+        }
+        file->size = (uintmax_t) st.st_size;
+        file->modified = st.st_mtime;
+        file->inode = st.st_ino;
+        file->validated = std::chrono::steady_clock::now();
+
+        char hex[2][10];
+        file->etag.assign("\"").append(hex[0], (size_t) utils::u32toaHex((unsigned int) file->size, hex[0])).append("-")
+            .append(hex[1], (size_t) utils::u32toaHex((unsigned int) file->modified, hex[1])).append("\"");
+        file->lastModified = formatHttpDate(file->modified);
+        file->contentType = contentType;
+        file->encoding = encoding;
+
+        if (encoding == ENCODING_IDENTITY) {
+            file->gzip = load(path + ".gz", contentType, ENCODING_GZIP);
+            file->brotli = load(path + ".br", contentType, ENCODING_BROTLI);
+        }
+        file->varies = encoding != ENCODING_IDENTITY || file->gzip || file->brotli;
+
+        if (file->size <= cache->maxInMemorySize) {
+            std::string body(file->size, 0);
+            for (size_t offset = 0; offset < body.length(); ) {
+                ssize_t length = pread(fd, body.data() + offset, body.length() - offset, (off_t) offset);
+                if (length <= 0) {
+                    return nullptr;
+                }
+                offset += (size_t) length;
+            }
+
+            writeHeaders(file->response, *file);
+            file->response.end(body);
+            file->inMemory = true;
+
+            close(fd);
+            file->fd = -1;
+        }
+        return file;
+    }
+
+    static bool isUnchanged(const std::string &path, const StaticFile &file) {
+        struct stat st;
+        return !stat(path.c_str(), &st) && (uintmax_t) st.st_size == file.size && st.st_mtime == file.modified && st.st_ino == file.inode;
+    }
+
+    /* Whether If-None-Match lists our ETag, comparing weakly */
+    static bool matchesEtag(std::string_view ifNoneMatch, std::string_view etag) {
+        while (ifNoneMatch.length()) {
+            size_t comma = std::min<size_t>(ifNoneMatch.find(','), ifNoneMatch.length());
+            std::string_view candidate = ifNoneMatch.substr(0, comma);
+            ifNoneMatch.remove_prefix(std::min<size_t>(comma + 1, ifNoneMatch.length()));
+
+            while (candidate.length() && candidate.front() == ' ') candidate.remove_prefix(1);
+            while (candidate.length() && candidate.back() == ' ') candidate.remove_suffix(1);
+            if (candidate.substr(0, 2) == "W/") {
+                candidate.remove_prefix(2);
+            }
+            if (candidate == etag || candidate == "*") {
+                return true;
+            }
+        }
+        return false;
+    }
+
+public:
+    /* Serves files below root for URLs starting with prefix. At most maxFiles are cached, files up to maxInMemorySize
+     * bytes are held in memory, and cached files are checked for changes at most once per revalidateSeconds */
+    StaticFiles(std::string_view root, std::string_view prefix = "", size_t maxFiles = 1024, uintmax_t maxInMemorySize = 64 * 1024, unsigned int revalidateSeconds = 1)
+        : cache(std::make_shared<Cache>()) {
+        cache->root = root;
+        /* Our paths always start with a slash */
+        while (cache->root.length() && cache->root.back() == '/') {
+            cache->root.pop_back();
+        }
+        cache->prefix = prefix;
+        cache->maxFiles = maxFiles ? maxFiles : 1;
+        cache->maxInMemorySize = maxInMemorySize;
+        cache->revalidateInterval = std::chrono::seconds(revalidateSeconds);
+    }
+
+    /* Returns the file for a (still encoded) URL, or nullptr if there is none. Paths are decoded
+     * and normalized, so that nothing outside of root is ever reached */
+    std::shared_ptr<StaticFile> get(std::string_view url) {
+        if (url.substr(0, cache->prefix.length()) != cache->prefix) {
+            return nullptr;
+        }
+        url.remove_prefix(cache->prefix.length());
+
+        std::string path = "/";
+        path.append(url);
+        char *end = decodeUrl(path.data(), path.data() + path.length(), false);
+        if (!end || memchr(path.data(), 0, (size_t) (end - path.data()))) {
+            return nullptr;
+        }
+        path.resize((size_t) (normalizeUrlPath(path.data(), end) - path.data()));
+        if (path.back() == '/') {
+            path.append("index.html");
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> lock(cache->mutex);
+            auto it = cache->index.find(path);
+            if (it != cache->index.end()) {
+                cache->files.splice(cache->files.begin(), cache->files, it->second);
+                std::shared_ptr<StaticFile> file = it->second->second;
+                if (now - file->validated < cache->revalidateInterval) {
+                    return file;
+                }
+
+                /* Unchanged files just get a new lease. Siblings that appear later are seen once their original changes */
+                std::string fullPath = cache->root + path;
+                if (isUnchanged(fullPath, *file) && (!file->gzip || isUnchanged(fullPath + ".gz", *file->gzip)) && (!file->brotli || isUnchanged(fullPath + ".br", *file->brotli))) {
+                    file->validated = now;
+                    return file;
+                }
+            }
+        }
+
+        /* Files are opened and read without holding the lock */
+        std::shared_ptr<StaticFile> file = load(cache->root + path, getContentType(path));
+
+        std::lock_guard<std::mutex> lock(cache->mutex);
+        auto it = cache->index.find(path);
+        if (it != cache->index.end()) {
+            auto cached = it->second;
+            cache->index.erase(it);
+            cache->files.erase(cached);
+        }
+        if (file) {
+            cache->files.emplace_front(std::move(path), file);
+            cache->index.emplace(cache->files.front().first, cache->files.begin());
+
+            /* Evicted files close when their last response is done with them */
+            if (cache->files.size() > cache->maxFiles) {
+                cache->index.erase(cache->files.back().first);
+                cache->files.pop_back();
+            }
+        }
+        return file;
+    }
+
+    template <class HttpResponse, class HttpRequest>
+    void operator()(HttpResponse *res, HttpRequest *req) {
+        std::shared_ptr<StaticFile> file = get(req->getUrl());
+        if (!file) {
+            res->writeStatus("404 Not Found");
+            res->end();
+            return;
+        }
+
+        /* Precompressed siblings are served whole, ranges come from the original */
+        std::string_view range = req->getHeader(WellKnownHeaders::RANGE);
+        if (file->varies && !range.length()) {
+            unsigned int available = (file->gzip ? ENCODING_GZIP : 0) | (file->brotli ? ENCODING_BROTLI : 0);
+            HttpEncoding encoding = negotiateEncoding(req->getHeader(WellKnownHeaders::ACCEPT_ENCODING), available);
+            if (encoding == ENCODING_GZIP) {
+                file = file->gzip;
+            } else if (encoding == ENCODING_BROTLI) {
+                file = file->brotli;
+            }
+        }
+
+        /* If-None-Match takes precedence over If-Modified-Since */
+        std::string_view ifNoneMatch = req->getHeader(WellKnownHeaders::IF_NONE_MATCH);
+        if (ifNoneMatch.length() ? matchesEtag(ifNoneMatch, file->etag) : req->getHeader(WellKnownHeaders::IF_MODIFIED_SINCE) == file->lastModified) {
+            res->writeStatus("304 Not Modified");
+            if (file->varies) {
+                res->writeHeader("Vary", "Accept-Encoding");
+            }
+            res->writeHeader("ETag", file->etag);
+            res->writeHeader("Last-Modified", file->lastModified);
+            res->endWithoutBody();
+            return;
+        }
+
+        /* Ranges only apply to the representation the client has, if it says which */
+        uintmax_t offset = 0, length = file->size;
+        RangeResult rangeResult = RANGE_NONE;
+        std::string_view ifRange = req->getHeader("if-range");
+        if (range.length() && (!ifRange.length() || ifRange == file->etag || ifRange == file->lastModified)) {
+            rangeResult = parseRange(range, file->size, offset, length);
+        }
+
+        if (rangeResult == RANGE_NONE && file->inMemory) {
+            res->end(file->response);
+            return;
+        }
+
+        char contentRange[64];
+        if (rangeResult == RANGE_UNSATISFIABLE) {
+            int contentRangeLength = snprintf(contentRange, sizeof(contentRange), "bytes */%ju", file->size);
+            res->writeStatus("416 Range Not Satisfiable");
+            res->writeHeader("Content-Range", std::string_view(contentRange, (size_t) contentRangeLength));
+            res->end();
+            return;
+        }
+        if (rangeResult == RANGE_PARTIAL) {
+            int contentRangeLength = snprintf(contentRange, sizeof(contentRange), "bytes %ju-%ju/%ju", offset, offset + length - 1, file->size);
+            res->writeStatus("206 Partial Content");
+            res->writeHeader("Content-Range", std::string_view(contentRange, (size_t) contentRangeLength));
+        }
+        writeHeaders(*res, *file);
+
+        if (file->inMemory) {
+            res->end(file->response.getBody().substr((size_t) offset, (size_t) length));
+            return;
+        }
+
+        /* The file stays open, even if evicted, until the response is done or aborted */
+        res->onAborted([file]() {});
+        res->sendFile(file->fd, offset, length);
+    }
+};
+
+}
+
+#endif
+
+#endif // UWS_STATICFILES_H
@@ -0,0 +1,140 @@
+/*
+ * Authored by Alex Hultman, 2018-2023.
+ * Intellectual property of third-party.
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *     http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* This module implements in place percent-decoding and path normalization of URLs.
+ * Both only ever shrink their input; runs without anything to do are found with the
+ * vector kernels and moved as a whole (or not at all, if nothing was removed before them) */
+
+#ifndef UWS_URLDECODER_H
+#define UWS_URLDECODER_H
+
+#include <cstring>
+
+#include "Simd.h"
+
+namespace uWS {
+
+    /* Values of hex digits, -1 for any other byte. A lookup does not mispredict on mixed digits and letters */
+    struct HexTable {
+        signed char values[256];
+
+        constexpr HexTable() : values() {
+            for (int c = 0; c < 256; c++) {
+                values[c] = (signed char) ((c >= '0' && c <= '9') ? c - '0' : (((c | 32) >= 'a' && (c | 32) <= 'f') ? (c | 32) - 'a' + 10 : -1));
+            }
+        }
+    };
+    static constexpr HexTable hexTable;
+
+    /* Returns the value of a hex digit or -1 */
+    static inline int hexValue(char c) {
+        return hexTable.values[(unsigned char) c];
+    }
+
+    /* Moves the run [p, stop) back to out and returns its new end. Short runs are moved byte by byte,
+     * calling memmove costs more than they do */
+    static inline char *moveRun(char *out, char *p, char *stop) {
+        if (out == p) {
+            return stop;
+        }
+        if (stop - p > 32) {
+            memmove(out, p, (size_t) (stop - p));
+            return out + (stop - p);
+        }
+        while (p < stop) {
+            *(out++) = *(p++);
+        }
+        return out;
+    }
+
+    /* Percent-decodes [begin, end) in place, optionally with '+' as space (as in queries, not in paths).
+     * Returns the new end, or nullptr for a malformed escape (in which case the input is left half decoded) */
+    static inline char *decodeUrl(char *begin, char *end, bool plusAsSpace) {
+        /* Escapes tend to come in groups, where going byte by byte (with predicted branches) beats a vector scan
+         * being one chain of dependent instructions. So we only scan wide once we have seen a few plain bytes */
+        const unsigned int PLAIN_BYTES_BEFORE_SCAN = 8;
+
+        char plus = plusAsSpace ? '+' : '%';
+        char *out = begin, *p = begin;
+        for (unsigned int plainBytes = 0; p < end; ) {
+            if (*p == '%') {
+                /* Do we have two hex digits? */
+                int hex1 = end - p < 3 ? -1 : hexValue(p[1]);
+                int hex2 = hex1 < 0 ? -1 : hexValue(p[2]);
+                if (hex2 < 0) {
+                    return nullptr;
+                }
+
+                *((unsigned char *) out++) = (unsigned char) (hex1 * 16 + hex2);
+                p += 3;
+                plainBytes = 0;
+            } else if (*p == plus) {
+                *(out++) = ' ';
+                p++;
+                plainBytes = 0;
+            } else if (++plainBytes < PLAIN_BYTES_BEFORE_SCAN) {
+                *(out++) = *(p++);
+            } else {
+                char *escape = simd::Native::findEither(p, end, '%', plus);
+                out = moveRun(out, p, escape);
+                p = escape;
+                plainBytes = 0;
+            }
+        }
+        return out;
+    }
+
+    /* Removes "." and ".." segments (RFC 3986, 5.2.4) and collapses repeated slashes of the path [begin, end)
+     * in place, returning the new end. Paths are expected to start with '/', ".." never leaves the root */
+    static inline char *normalizeUrlPath(char *begin, char *end) {
+        char *out = begin;
+        for (char *p = begin; ; ) {
+            /* Normal segments are moved as one run */
+            char *slash = simd::Native::findDotSegment(p, end);
+            out = moveRun(out, p, slash);
+
+            if (slash == end) {
+                return out;
+            }
+
+            /* We stand on the slash of a segment that is empty or starts with a dot */
+            char *segment = slash + 1;
+            char *segmentEnd = segment;
+            for (; segmentEnd < end && *segmentEnd != '/'; segmentEnd++);
+            size_t length = (size_t) (segmentEnd - segment);
+            bool isDot = length == 1 && segment[0] == '.';
+            bool isDotDot = length == 2 && segment[0] == '.' && segment[1] == '.';
+
+            if (isDotDot) {
+                /* Drop the last segment we have written, along with its slash */
+                while (out > begin && *(--out) != '/');
+            } else if (length && !isDot) {
+                /* Just a name starting with a dot */
+                out = moveRun(out, slash, segmentEnd);
+            }
+
+            /* Paths ending in "/." or "/.." refer to a directory */
+            if ((isDot || isDotDot) && segmentEnd == end) {
+                *(out++) = '/';
+            }
+            p = segmentEnd;
+        }
+    }
+
+}
+
+#endif // UWS_URLDECODER_H
@@ -31,6 +31,7 @@ template <bool SSL, bool isServer, typename USERDATA>
 struct WebSocket : AsyncSocket<SSL> {
     template <bool> friend struct TemplatedApp;
     template <bool> friend struct HttpResponse;
+    template <bool, bool, typename> friend struct WebSocket;
 private:
     typedef AsyncSocket<SSL> Super;
 
@@ -90,6 +91,22 @@ public:
     /* Send or buffer a WebSocket frame, compressed or not. Returns BACKPRESSURE on increased user space backpressure,
      * DROPPED on dropped message (due to backpressure) or SUCCCESS if you are free to send even more now. */
     SendStatus send(std::string_view message, OpCode opCode = OpCode::BINARY, bool compress = false, bool fin = true) {
+        return send(message, opCode, compress, fin, nullptr);
+    }
+
+    /* Send a message held in a SharedBuffer. Messages too large for the cork buffer are not copied to backpressure,
+     * it refers to the SharedBuffer until written off instead. Sending one to many sockets costs no copies at all */
+    SendStatus send(SharedBuffer *message, OpCode opCode = OpCode::BINARY, bool compress = false, bool fin = true) {
+        return send(std::string_view(message->data(), message->length()), opCode, compress, fin, nullptr, message);
+    }
+
+private:
+    /* Opcode byte, length byte and 64-bit extended length of an unmasked frame */
+    static const size_t MAX_FRAME_HEADER_SIZE = 10;
+
+    /* Send used when publishing, where an uncompressed frame that has to be buffered is shared by all subscribers,
+     * and for messages in a SharedBuffer */
+    SendStatus send(std::string_view message, OpCode opCode, bool compress, bool fin, PublishedFrame *publishedFrame, SharedBuffer *sharedMessage = nullptr) {
         WebSocketContextData<SSL, USERDATA> *webSocketContextData = (WebSocketContextData<SSL, USERDATA> *) us_socket_context_ext(SSL,
             (us_socket_context_t *) us_socket_context(SSL, (us_socket_t *) this)
         );
@@ -130,23 +147,59 @@ public:
 
         /* Get size, allocate size, write if needed */
         size_t messageFrameSize = protocol::messageFrameSize(message.length());
-        auto [sendBuffer, sendBufferAttribute] = Super::getSendBuffer(messageFrameSize);
-        protocol::formatMessage<isServer>(sendBuffer, message.data(), message.length(), opCode, message.length(), compress, fin);
-
-        /* Depending on size of message we have different paths */
-        if (sendBufferAttribute == SendBufferAttribute::NEEDS_DRAIN) {
-            /* This is a drain */
-            auto[written, failed] = Super::write(nullptr, 0);
-            if (failed) {
-                /* Return false for failure, skipping to reset the timeout below */
+
+        /* Behind backpressure, refer to the published frame rather than copying it. Server frames are not masked so all subscribers get the same */
+        if (isServer && publishedFrame && !compress && messageFrameSize >= PublishedFrame::MIN_SHARED_SIZE && Super::getBufferedAmount()) {
+            if (!publishedFrame->sharedBuffer) {
+                publishedFrame->sharedBuffer = SharedBuffer::create(messageFrameSize);
+                protocol::formatMessage<isServer>(publishedFrame->sharedBuffer->data(), message.data(), message.length(), opCode, message.length(), false, fin);
+            }
+            if (Super::writeShared(publishedFrame->sharedBuffer).second) {
                 return BACKPRESSURE;
             }
-        } else if (sendBufferAttribute == SendBufferAttribute::NEEDS_UNCORK) {
-            /* Uncork if we came here uncorked */
-            auto [written, failed] = Super::uncork();
-            if (failed) {
+        } else if (isServer && sharedMessage && !compress && messageFrameSize >= Super::getLoopData()->corkBufferSize) {
+            /* Only the header is copied, the payload is referenced where it is */
+            char frameHeader[MAX_FRAME_HEADER_SIZE];
+            size_t headerLength = protocol::formatMessage<isServer>(frameHeader, message.data(), 0, opCode, message.length(), false, fin);
+            if (Super::writeShared(sharedMessage, std::string_view(frameHeader, headerLength)).second) {
                 return BACKPRESSURE;
             }
+        } else if (!SSL && isServer && messageFrameSize >= Super::getLoopData()->corkBufferSize && !Super::getBufferedAmount()
+            && (!Super::isCorked() || Super::getLoopData()->corkOffset + MAX_FRAME_HEADER_SIZE <= Super::getLoopData()->corkBufferSize)) {
+            /* Too large for the cork buffer, so rather than copying it to backpressure, send the header (behind anything corked) and the payload in one go */
+            LoopData *loopData = Super::getLoopData();
+            char frameHeader[MAX_FRAME_HEADER_SIZE];
+            char *head = frameHeader;
+            size_t headLength = protocol::formatMessage<isServer>(frameHeader, message.data(), 0, opCode, message.length(), compress, fin);
+            if (Super::isCorked()) {
+                /* We stay corked, with the cork buffer written off */
+                memcpy(loopData->corkBuffer + loopData->corkOffset, frameHeader, headLength);
+                head = loopData->corkBuffer;
+                headLength += loopData->corkOffset;
+                loopData->corkOffset = 0;
+            }
+            if (Super::writeVectored(head, (int) headLength, message.data(), (int) message.length()).second) {
+                return BACKPRESSURE;
+            }
+        } else {
+            auto [sendBuffer, sendBufferAttribute] = Super::getSendBuffer(messageFrameSize);
+            protocol::formatMessage<isServer>(sendBuffer, message.data(), message.length(), opCode, message.length(), compress, fin);
+
+            /* Depending on size of message we have different paths */
+            if (sendBufferAttribute == SendBufferAttribute::NEEDS_DRAIN) {
+                /* This is a drain */
+                auto[written, failed] = Super::write(nullptr, 0);
+                if (failed) {
+                    /* Return false for failure, skipping to reset the timeout below */
+                    return BACKPRESSURE;
+                }
+            } else if (sendBufferAttribute == SendBufferAttribute::NEEDS_UNCORK) {
+                /* Uncork if we came here uncorked */
+                auto [written, failed] = Super::uncork();
+                if (failed) {
+                    return BACKPRESSURE;
+                }
+            }
         }
 
         /* Every successful send resets the timeout */
@@ -160,6 +213,7 @@ public:
         return SUCCESS;
     }
 
+public:
     /* Send websocket close frame, emit close event, send FIN if successful.
      * Will not append a close reason if code is 0 or 1005. */
     void end(int code = 0, std::string_view message = {}) {
@@ -335,11 +389,11 @@ public:
         }
 
         /* Publish as sender, does not receive its own messages even if subscribed to relevant topics */
-        if (message.length() >= LoopData::CORK_BUFFER_SIZE) {
+        if (message.length() >= Super::getLoopData()->corkBufferSize) {
             return webSocketContextData->topicTree->publishBig(webSocketData->subscriber, topic, {message, opCode, compress}, [](Subscriber *s, TopicTreeBigMessage &message) {
                 auto *ws = (WebSocket<SSL, true, int> *) s->user;
 
-                ws->send(message.message, (OpCode)message.opCode, message.compress);
+                ws->send(message.message, (OpCode)message.opCode, message.compress, true, &message.frame);
             });
         } else {
             return webSocketContextData->topicTree->publish(webSocketData->subscriber, topic, {std::string(message), opCode, compress});
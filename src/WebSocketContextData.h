@@ -31,16 +31,44 @@
 
 namespace uWS {
 
+/* The uncompressed frame of a published message, made when the first subscriber has to buffer it
+ * and then shared by the backpressure of every other subscriber that does */
+struct PublishedFrame {
+    /* Smaller frames are copied, a reference costs about as much */
+    static const size_t MIN_SHARED_SIZE = 1024;
+
+    SharedBuffer *sharedBuffer = nullptr;
+
+    PublishedFrame() = default;
+    PublishedFrame(const PublishedFrame &other) : sharedBuffer(other.sharedBuffer) {
+        if (sharedBuffer) {
+            sharedBuffer->retain();
+        }
+    }
+    PublishedFrame(PublishedFrame &&other) : sharedBuffer(other.sharedBuffer) {
+        other.sharedBuffer = nullptr;
+    }
+    PublishedFrame &operator=(const PublishedFrame &) = delete;
+
+    ~PublishedFrame() {
+        if (sharedBuffer) {
+            sharedBuffer->release();
+        }
+    }
+};
+
 /* Type queued up when publishing */
 struct TopicTreeMessage {
     std::string message;
     /*OpCode*/ int opCode;
     bool compress;
+    PublishedFrame frame = {};
 };
 struct TopicTreeBigMessage {
     std::string_view message;
     /*OpCode*/ int opCode;
     bool compress;
+    PublishedFrame frame = {};
 };
 
 template <bool, bool, typename> struct WebSocket;
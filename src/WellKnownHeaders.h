@@ -0,0 +1,143 @@
+/*
+ * Authored by Alex Hultman, 2018-2023.
+ * Intellectual property of third-party.
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *     http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UWS_WELLKNOWNHEADERS_H
+#define UWS_WELLKNOWNHEADERS_H
+
+/* Pre-interned request headers. The parser classifies every lower-cased header name
+ * into a fixed slot, so that looking up any of these is a single indexed load.
+ * The perfect hash has no collisions for the names below, which is checked at compile time */
+
+#include <string_view>
+#include <array>
+#include <cstdint>
+
+namespace uWS {
+
+struct WellKnownHeaders {
+    /* Must be kept in the same order as names */
+    enum Id : unsigned char {
+        HOST,
+        CONTENT_LENGTH,
+        TRANSFER_ENCODING,
+        CONNECTION,
+        UPGRADE,
+        EXPECT,
+        USER_AGENT,
+        COOKIE,
+        SEC_WEBSOCKET_KEY,
+        SEC_WEBSOCKET_PROTOCOL,
+        SEC_WEBSOCKET_EXTENSIONS,
+        SEC_WEBSOCKET_VERSION,
+        CONTENT_TYPE,
+        ACCEPT,
+        ACCEPT_ENCODING,
+        ACCEPT_LANGUAGE,
+        ORIGIN,
+        AUTHORIZATION,
+        REFERER,
+        CACHE_CONTROL,
+        IF_NONE_MATCH,
+        IF_MODIFIED_SINCE,
+        RANGE,
+        X_FORWARDED_FOR,
+        /* Number of well-known headers, also used to signal a custom header */
+        UNKNOWN
+    };
+
+    static constexpr std::string_view names[UNKNOWN] = {
+        "host",
+        "content-length",
+        "transfer-encoding",
+        "connection",
+        "upgrade",
+        "expect",
+        "user-agent",
+        "cookie",
+        "sec-websocket-key",
+        "sec-websocket-protocol",
+        "sec-websocket-extensions",
+        "sec-websocket-version",
+        "content-type",
+        "accept",
+        "accept-encoding",
+        "accept-language",
+        "origin",
+        "authorization",
+        "referer",
+        "cache-control",
+        "if-none-match",
+        "if-modified-since",
+        "range",
+        "x-forwarded-for"
+    };
+
+private:
+    static const unsigned int SLOTS_LOG2 = 5;
+
+    /* Length, first, last and middle byte are enough to tell these apart (key must not be empty) */
+    static constexpr unsigned int perfectHash(std::string_view key) {
+        uint32_t features = (uint32_t) (key.length() & 0xff)
+            | ((uint32_t) (unsigned char) key[0] << 8)
+            | ((uint32_t) (unsigned char) key[key.length() - 1] << 16)
+            | ((uint32_t) (unsigned char) key[key.length() >> 1] << 24);
+        return (unsigned int) ((features * 3643800115u) >> (32 - SLOTS_LOG2));
+    }
+
+    /* Slot holds Id + 1, or 0 for empty */
+    static constexpr std::array<unsigned char, 1 << SLOTS_LOG2> makeSlots() {
+        std::array<unsigned char, 1 << SLOTS_LOG2> slots = {};
+        for (unsigned int i = 0; i < UNKNOWN; i++) {
+            slots[perfectHash(names[i])] = (unsigned char) (i + 1);
+        }
+        return slots;
+    }
+
+    /* Whether every name lands in a slot of its own */
+    static constexpr bool isPerfect() {
+        std::array<bool, 1 << SLOTS_LOG2> taken = {};
+        for (unsigned int i = 0; i < UNKNOWN; i++) {
+            unsigned int slot = perfectHash(names[i]);
+            if (taken[slot]) {
+                return false;
+            }
+            taken[slot] = true;
+        }
+        return true;
+    }
+
+public:
+    /* Returns the Id of a lower-cased header name, or UNKNOWN for custom headers */
+    static inline Id classify(std::string_view lowerCasedHeader) {
+        static_assert(isPerfect(), "Well-known header names collide, change the hash or SLOTS_LOG2");
+        static constexpr std::array<unsigned char, 1 << SLOTS_LOG2> slots = makeSlots();
+
+        if (!lowerCasedHeader.length()) {
+            return UNKNOWN;
+        }
+
+        unsigned int slot = slots[perfectHash(lowerCasedHeader)];
+        if (slot && names[slot - 1] == lowerCasedHeader) {
+            return (Id) (slot - 1);
+        }
+        return UNKNOWN;
+    }
+};
+
+}
+
+#endif // UWS_WELLKNOWNHEADERS_H
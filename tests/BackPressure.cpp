@@ -0,0 +1,88 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+
+#include "../src/AsyncSocketData.h"
+
+/* Concatenates what getSegments gives */
+std::string gather(uWS::BackPressure &backPressure) {
+    std::string_view segments[64];
+    std::string gathered;
+    size_t numSegments = backPressure.getSegments(segments, 64);
+    for (size_t i = 0; i < numSegments; i++) {
+        gathered.append(segments[i]);
+    }
+    return gathered;
+}
+
+int main() {
+    uWS::BackPressure backPressure;
+    assert(!backPressure.length() && !backPressure.front().length() && gather(backPressure) == "");
+
+    /* Fill with small and large appends, plus contiguous allocations, and compare with a string */
+    std::string expected;
+    for (size_t i = 0; i < 200; i++) {
+        size_t length = (i * 7919) % (3 * uWS::BackPressure::SEGMENT_SIZE);
+        std::string data(length, (char) ('a' + i % 26));
+        if (i % 3) {
+            backPressure.append(data.data(), data.length());
+        } else {
+            char *dst = backPressure.allocate(data.length());
+            memcpy(dst, data.data(), data.length());
+        }
+        expected.append(data);
+        assert(backPressure.length() == expected.length());
+    }
+    assert(gather(backPressure) == expected.substr(0, gather(backPressure).length()));
+
+    /* Write it off at odd offsets, front first */
+    std::string written;
+    while (backPressure.length()) {
+        std::string_view front = backPressure.front();
+        assert(front.length());
+        size_t length = std::min<size_t>(front.length(), 1 + written.length() % 10007);
+        written.append(front.substr(0, length));
+        backPressure.erase(length);
+        assert(backPressure.length() == expected.length() - written.length());
+    }
+    assert(written == expected);
+
+    /* Erasing across segments at once, and moving */
+    backPressure.append(expected.data(), expected.length());
+    backPressure.erase(uWS::BackPressure::SEGMENT_SIZE * 5 + 3);
+    uWS::BackPressure moved(std::move(backPressure));
+    assert(!backPressure.length() && gather(backPressure) == "");
+    assert(moved.length() == expected.length() - uWS::BackPressure::SEGMENT_SIZE * 5 - 3);
+    assert(moved.front() == std::string_view(expected).substr(uWS::BackPressure::SEGMENT_SIZE * 5 + 3, moved.front().length()));
+    moved.erase(moved.length() + 100);
+    assert(!moved.length() && !moved.front().length());
+
+    moved.append("hello", 5);
+    moved.clear();
+    assert(!moved.length());
+
+    /* One shared buffer held by many, between copies, freed by whoever lets go last (ASan checks the rest) */
+    uWS::SharedBuffer *sharedBuffer = uWS::SharedBuffer::create(4096);
+    memset(sharedBuffer->data(), 'S', 4096);
+    {
+        uWS::BackPressure subscribers[100];
+        for (uWS::BackPressure &subscriber : subscribers) {
+            subscriber.append("ab", 2);
+            subscriber.append(sharedBuffer);
+            subscriber.allocate(1)[0] = 'c';
+            assert(subscriber.length() == 4099);
+            assert(gather(subscriber) == "ab" + std::string(4096, 'S') + "c");
+        }
+        sharedBuffer->release();
+
+        /* Write off into the middle of it, then past it */
+        subscribers[0].erase(1000);
+        assert(subscribers[0].front() == std::string(3098, 'S'));
+        subscribers[0].erase(3098);
+        assert(subscribers[0].front() == "c");
+        assert(subscribers[1].front() == "ab");
+    }
+
+    std::cout << "ALL DONE" << std::endl;
+    return 0;
+}
@@ -211,9 +211,81 @@ void testWithoutTrailer() {
     }
 }
 
+/* Decodes buffer split in pieces of maxConsume bytes, with ChunkIterator or consumeChunks, and returns
+ * the data (with '|' for every empty last chunk), consumed bytes and states between pieces */
+std::string decodeAll(std::string buffer, unsigned int maxConsume, bool batched) {
+    std::string result;
+    unsigned int state = uWS::STATE_IS_CHUNKED;
+
+    for (size_t offset = 0; offset < buffer.length() && state; ) {
+        std::string_view data(buffer.data() + offset, std::min<size_t>(maxConsume, buffer.length() - offset));
+        size_t before = data.length();
+
+        if (batched) {
+            uWS::consumeChunks(data, state, true, [&result](std::string_view chunk) {
+                result += chunk.length() ? std::string(chunk) : "|";
+            });
+        } else {
+            for (auto chunk : uWS::ChunkIterator(&data, &state, true)) {
+                result += chunk.length() ? std::string(chunk) : "|";
+            }
+        }
+
+        offset += before - data.length();
+        result += "<" + std::to_string(before - data.length()) + ":" + std::to_string(state) + ">";
+        if (uWS::isParsingInvalidChunkedEncoding(state)) {
+            break;
+        }
+    }
+
+    return result;
+}
+
+void testBatched() {
+    /* Small and big chunks, upper and lower case sizes, with and without leading zeros */
+    std::string buffer;
+    for (int i = 0; i < 200; i++) {
+        unsigned int length = (i * 37) % 150 + (i % 25 == 0 ? 3000 : 1);
+        std::string data(length, (char) ('a' + i % 26));
+        std::stringstream ss;
+        ss << std::hex << (i % 3 == 0 ? std::uppercase : std::nouppercase) << (i % 7 == 0 ? "00" : "") << length << "\r\n" << data << "\r\n";
+        buffer += ss.str();
+    }
+    buffer += "0\r\n\r\n";
+
+    /* Anything but a plain size line is left to the byte at a time parser, errors included */
+    assert(decodeAll("5\r\nhello\r\n5;ext=1\r\nworld\r\n0\r\n\r\n", 100, true) == decodeAll("5\r\nhello\r\n5;ext=1\r\nworld\r\n0\r\n\r\n", 100, false));
+
+    /* Same data, consumption and states in every split, while batching calls the handler far less often */
+    for (unsigned int maxConsume : {1u, 2u, 7u, 8u, 9u, 100u, 1000u, 100000u}) {
+        assert(decodeAll(buffer, maxConsume, false) == decodeAll(buffer, maxConsume, true));
+    }
+
+    {
+        unsigned int state = uWS::STATE_IS_CHUNKED, calls = 0;
+        std::string copy = buffer;
+        std::string_view data = copy;
+        uWS::consumeChunks(data, state, false, [&calls](std::string_view) {
+            calls++;
+        });
+        assert(state == 0 && !data.length());
+        assert(calls < 30);
+    }
+
+    /* Size line parsing */
+    unsigned int size = 0;
+    assert(uWS::parseChunkSizeLine("7fFfFfF\r\n", size) == 7 && size == 0x7ffffff);
+    assert(uWS::parseChunkSizeLine("0a\r\n....", size) == 2 && size == 10);
+    assert(uWS::parseChunkSizeLine("1g\r\n....", size) == 0);
+    assert(uWS::parseChunkSizeLine("12345678\r\n", size) == 0);
+    assert(uWS::parseChunkSizeLine("a;b=c\r\n..", size) == 0);
+    assert(uWS::parseChunkSizeLine(":\r\n.....", size) == 0);
+}
+
 int main() {
 
     testWithoutTrailer();
+    testBatched();
 
     for (int i = 1; i < 1000; i++) {
         runBetterTest(i);
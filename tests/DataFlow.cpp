@@ -0,0 +1,210 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+
+#include "../src/DataFlow.h"
+#include "../src/AsyncSocketData.h"
+
+/* Proxies a large upload into a slow sink the way HttpContext and HttpResponse::resumeData drive a DataFlow:
+ * reads stop when the handler says so, but the rest of the current read is still handed over (and held) */
+void testSlowSink() {
+    const size_t UPLOAD_SIZE = 8 * 1024 * 1024, READ_SIZE = 64 * 1024, PARSED_SIZE = 16 * 1024;
+    const size_t SINK_HIGH = 32 * 1024, SINK_LOW = 16 * 1024, SINK_DRAIN = 8 * 1024;
+
+    std::string upload(UPLOAD_SIZE, 0);
+    for (size_t i = 0; i < UPLOAD_SIZE; i++) {
+        upload[i] = (char) (i * 7 + i / 4096);
+    }
+
+    uWS::DataFlow dataFlow;
+    std::string sink, proxied;
+    int fins = 0;
+    size_t maxHeld = 0, maxSink = 0, readOffset = 0;
+    bool paused = false;
+
+    auto handler = [&](std::string_view chunk, bool fin) {
+        sink.append(chunk);
+        fins += fin;
+        maxSink = std::max(maxSink, sink.length());
+        return sink.length() < SINK_HIGH;
+    };
+
+    while (proxied.length() < UPLOAD_SIZE) {
+        /* One read, parsed into a few pieces like a chunked body */
+        if (!paused && readOffset < UPLOAD_SIZE) {
+            size_t end = std::min(readOffset + READ_SIZE, UPLOAD_SIZE);
+            for (; readOffset < end; readOffset += PARSED_SIZE) {
+                size_t length = std::min(PARSED_SIZE, end - readOffset);
+                if (!dataFlow.deliver(std::string_view(upload).substr(readOffset, length), readOffset + length == UPLOAD_SIZE, handler)) {
+                    paused = true;
+                }
+            }
+            maxHeld = std::max(maxHeld, dataFlow.heldLength());
+        }
+
+        /* The sink drains slowly and wants more once below its low mark */
+        size_t drained = std::min(SINK_DRAIN, sink.length());
+        proxied.append(sink, 0, drained);
+        sink.erase(0, drained);
+        if (paused && sink.length() < SINK_LOW && dataFlow.resume(handler)) {
+            paused = false;
+        }
+    }
+
+    assert(proxied == upload);
+    assert(fins == 1);
+    assert(!dataFlow.isStopped() && !dataFlow.heldLength());
+
+    /* We never hold more than one read, and the sink goes over its mark by at most that */
+    assert(maxHeld <= READ_SIZE);
+    assert(maxSink <= SINK_HIGH + READ_SIZE);
+}
+
+void testFin() {
+    uWS::DataFlow dataFlow;
+    std::string got;
+    int fins = 0;
+    bool accept = false;
+
+    auto handler = [&](std::string_view chunk, bool fin) {
+        got.append(chunk);
+        fins += fin;
+        return accept;
+    };
+
+    /* Stopping on the last chunk means nothing */
+    assert(dataFlow.deliver("abc", true, handler) && !dataFlow.isStopped());
+    assert(got == "abc" && fins == 1);
+
+    /* A held empty fin is still handed over */
+    got.clear();
+    fins = 0;
+    assert(!dataFlow.deliver("abc", false, handler) && dataFlow.isStopped());
+    assert(!dataFlow.deliver("def", false, handler));
+    assert(!dataFlow.deliver("", true, handler));
+    assert(got == "abc" && fins == 0 && dataFlow.heldLength() == 3);
+    assert(dataFlow.resume(handler) && got == "abcdef" && fins == 1);
+
+    /* Resuming into a handler that stops again keeps us stopped, with nothing held */
+    got.clear();
+    fins = 0;
+    assert(!dataFlow.deliver("abc", false, handler));
+    assert(!dataFlow.deliver("def", false, handler));
+    assert(!dataFlow.resume(handler) && dataFlow.isStopped() && !dataFlow.heldLength());
+    assert(got == "abcdef" && fins == 0);
+    accept = true;
+    assert(dataFlow.resume(handler) && got == "abcdef");
+
+    /* Resuming when flowing does nothing */
+    assert(dataFlow.resume(handler) && got == "abcdef");
+
+    dataFlow.reset();
+    assert(!dataFlow.isStopped() && !dataFlow.heldLength());
+}
+
+/* Responding while stopped and never resuming, like HttpResponse::markDone: the rest of the body
+ * is dropped and the next request on the connection must flow again */
+void testRespondWhileStopped() {
+    uWS::DataFlow dataFlow;
+    std::string got;
+    int fins = 0;
+
+    auto stopping = [&](std::string_view chunk, bool fin) {
+        got.append(chunk);
+        fins += fin;
+        return false;
+    };
+
+    assert(!dataFlow.deliver("abc", false, stopping) && dataFlow.isStopped());
+    assert(!dataFlow.deliver("def", false, stopping) && dataFlow.heldLength() == 3);
+
+    /* The response is done */
+    dataFlow.reset();
+    assert(!dataFlow.isStopped() && !dataFlow.heldLength());
+
+    /* Nothing held is ever handed over, and the next body flows */
+    auto accepting = [&](std::string_view chunk, bool fin) {
+        got.append(chunk);
+        fins += fin;
+        return true;
+    };
+    assert(dataFlow.resume(accepting) && got == "abc");
+    assert(dataFlow.deliver("ghi", false, accepting) && dataFlow.deliver("", true, accepting));
+    assert(got == "abcghi" && fins == 1 && !dataFlow.isStopped());
+}
+
+/* Stops reading, responds until backpressure builds, then resumes, with poll events changing the way uSockets
+ * changes them: failed writes poll for readable and writable, a drained socket stops polling for writable */
+void testStopWithBackPressure() {
+    const int READABLE = LIBUS_SOCKET_READABLE, WRITABLE = LIBUS_SOCKET_WRITABLE;
+    const size_t KERNEL_TAKES = 16 * 1024;
+
+    uWS::PollControl pollControl;
+    uWS::BackPressure backPressure;
+    int events = READABLE;
+
+    /* Writes off what the kernel takes, like AsyncSocket::socketWrite does */
+    auto drain = [&]() {
+        backPressure.erase(KERNEL_TAKES);
+        if (backPressure.length()) {
+            events = pollControl.afterFailedWrite(READABLE | WRITABLE);
+        } else {
+            events &= READABLE;
+        }
+    };
+
+    /* onData returned false */
+    events = pollControl.stopReading(events);
+    assert(events == 0);
+
+    /* The response goes out in pieces, faster than the kernel takes it */
+    std::string piece(24 * 1024, 'r');
+    for (int i = 0; i < 20; i++) {
+        backPressure.append(piece.data(), piece.length());
+        drain();
+        assert(events == WRITABLE);
+
+        /* Stopping again (as for the rest of a read) must not take writable away */
+        events = pollControl.stopReading(events);
+        assert(events == WRITABLE);
+    }
+    assert(backPressure.length() > KERNEL_TAKES);
+
+    /* Pausing takes everything, resuming gives writable back */
+    events = pollControl.pause(events);
+    assert(events == 0);
+    events = pollControl.pause(events);
+    events = pollControl.resume(events);
+    assert(events == WRITABLE);
+
+    /* Draining never has us read */
+    drain();
+    assert(events == WRITABLE);
+
+    /* resumeData, while still draining */
+    events = pollControl.resumeReading(events);
+    assert(events == (READABLE | WRITABLE));
+    while (backPressure.length()) {
+        assert(events & WRITABLE);
+        drain();
+    }
+    assert(events == READABLE);
+
+    /* Resuming reading while paused takes effect on resume */
+    events = pollControl.stopReading(events);
+    events = pollControl.pause(events);
+    events = pollControl.resumeReading(events);
+    assert(events == 0);
+    events = pollControl.resume(events);
+    assert(events == READABLE);
+}
+
+int main() {
+    testSlowSink();
+    testFin();
+    testRespondWhileStopped();
+    testStopWithBackPressure();
+
+    std::cout << "ALL DONE" << std::endl;
+    return 0;
+}
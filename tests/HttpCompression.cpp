@@ -0,0 +1,74 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+
+#include "../src/HttpCompression.h"
+
+/* Decodes gzip or zlib format */
+static std::string inflateAll(std::string_view compressed, bool gzip) {
+    z_stream stream = {};
+    inflateInit2(&stream, gzip ? 15 + 16 : 15);
+    stream.next_in = (Bytef *) compressed.data();
+    stream.avail_in = (unsigned int) compressed.length();
+
+    std::string raw;
+    char buffer[1024];
+    int err;
+    do {
+        stream.next_out = (Bytef *) buffer;
+        stream.avail_out = sizeof(buffer);
+        err = inflate(&stream, Z_NO_FLUSH);
+        raw.append(buffer, sizeof(buffer) - stream.avail_out);
+    } while (err == Z_OK);
+    assert(err == Z_STREAM_END);
+    inflateEnd(&stream);
+    return raw;
+}
+
+int main() {
+
+    {
+        /* Negotiation, preferring brotli then gzip on ties */
+        unsigned int all = uWS::ENCODING_GZIP | uWS::ENCODING_DEFLATE | uWS::ENCODING_BROTLI;
+        assert(uWS::negotiateEncoding("gzip, deflate, br", all) == uWS::ENCODING_BROTLI);
+        assert(uWS::negotiateEncoding("gzip, deflate, br", uWS::ENCODING_GZIP | uWS::ENCODING_DEFLATE) == uWS::ENCODING_GZIP);
+        assert(uWS::negotiateEncoding("deflate;q=0.9, gzip;q=0.5", all) == uWS::ENCODING_DEFLATE);
+        assert(uWS::negotiateEncoding("br;q=0, GZIP", all) == uWS::ENCODING_GZIP);
+        assert(uWS::negotiateEncoding("*", all) == uWS::ENCODING_BROTLI);
+        assert(uWS::negotiateEncoding("*;q=0.1, gzip;q=0.2", all) == uWS::ENCODING_GZIP);
+        assert(uWS::negotiateEncoding("*, br;q=0, gzip;q=0", all) == uWS::ENCODING_DEFLATE);
+        assert(uWS::negotiateEncoding("gzip;q=0.000", all) == uWS::ENCODING_IDENTITY);
+        assert(uWS::negotiateEncoding("identity", all) == uWS::ENCODING_IDENTITY);
+        assert(uWS::negotiateEncoding("", all) == uWS::ENCODING_IDENTITY);
+        assert(uWS::negotiateEncoding("gzip", 0) == uWS::ENCODING_IDENTITY);
+    }
+
+    uWS::ZlibContext zlibContext;
+    std::string json;
+    for (int i = 0; i < 2000; i++) {
+        json += "{\"id\":" + std::to_string(i) + ",\"name\":\"item\"},";
+    }
+
+    for (uWS::HttpEncoding encoding : {uWS::ENCODING_GZIP, uWS::ENCODING_DEFLATE}) {
+        uWS::HttpCompressionStream stream(encoding);
+
+        /* Whole bodies, over and over with the same stream */
+        for (int i = 0; i < 3; i++) {
+            std::string compressed(stream.compress(&zlibContext, json, true));
+            stream.reset();
+            assert(compressed.length() < json.length() / 4);
+            assert(inflateAll(compressed, encoding == uWS::ENCODING_GZIP) == json);
+        }
+
+        /* Bodies in pieces, of many parts each, then an empty end */
+        std::string compressed;
+        std::string_view parts[3] = {std::string_view(json).substr(0, 100), "", std::string_view(json).substr(100, 1000)};
+        compressed += stream.compress(&zlibContext, parts, 3, false);
+        compressed += stream.compress(&zlibContext, std::string_view(json).substr(1100), false);
+        compressed += stream.compress(&zlibContext, nullptr, 0, true);
+        assert(inflateAll(compressed, encoding == uWS::ENCODING_GZIP) == json);
+    }
+
+    std::cout << "ALL DONE" << std::endl;
+    return 0;
+}
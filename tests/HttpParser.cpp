@@ -1,9 +1,195 @@
 #include <iostream>
 #include <cassert>
+#include <string>
 
 #include "../src/HttpParser.h"
 
+/* Header names and values longer than any vector width, mixed case */
+void testLongHeaders() {
+    std::string key = "X-Some-Really-Long-Header-Name-That-Spans-Vectors";
+    std::string value = "Some value that is long enough to not fit in one single 32 byte wide vector";
+    std::string request = "GET /long HTTP/1.1\r\nHost: localhost\r\n" + key + ": " + value + "\r\nA:b\r\n\r\n";
+    request.append(uWS::MINIMUM_HTTP_POST_PADDING, '\0');
+
+    bool handled = false;
+    uWS::HttpParser httpParser;
+    httpParser.consumePostPadded(request.data(), (unsigned int) (request.length() - uWS::MINIMUM_HTTP_POST_PADDING), nullptr, nullptr, [&](void *s, uWS::HttpRequest *httpRequest) -> void * {
+        assert(httpRequest->getHeader("host") == "localhost");
+        assert(httpRequest->getHeader("x-some-really-long-header-name-that-spans-vectors") == value);
+        assert(httpRequest->getHeader("a") == "b");
+        handled = true;
+        return s;
+    }, [](void *user, std::string_view, bool) -> void * {
+        return user;
+    }, [](void *) -> void * {
+        return nullptr;
+    });
+
+    assert(handled);
+}
+
+/* Requests with more headers than fit inline spill into the overflow arena, up to the limit */
+void testManyHeaders(unsigned int count, bool expectHandled) {
+    std::string request = "GET /many HTTP/1.1\r\nHost: localhost\r\n";
+    for (unsigned int i = 1; i < count; i++) {
+        request += "X-Header-" + std::to_string(i) + ": " + std::to_string(i) + "\r\n";
+    }
+    request += "\r\n";
+    request.append(uWS::MINIMUM_HTTP_POST_PADDING, '\0');
+
+    bool handled = false;
+    uWS::HttpParser httpParser;
+    httpParser.consumePostPadded(request.data(), (unsigned int) (request.length() - uWS::MINIMUM_HTTP_POST_PADDING), nullptr, nullptr, [&](void *s, uWS::HttpRequest *httpRequest) -> void * {
+        assert(httpRequest->getHeader("host") == "localhost");
+        assert(httpRequest->getHeader("x-header-" + std::to_string(count - 1)) == std::to_string(count - 1));
+
+        unsigned int headers = 0;
+        for (auto header : *httpRequest) {
+            (void) header;
+            headers++;
+        }
+        assert(headers == count);
+
+        handled = true;
+        return s;
+    }, [](void *user, std::string_view, bool) -> void * {
+        return user;
+    }, [](void *) -> void * {
+        return nullptr;
+    });
+
+    assert(handled == expectHandled);
+}
+
+/* Feeds the request in pieces, each in its own post padded buffer like a socket would.
+ * Returns how many requests were handled and whether the error handler was called */
+std::pair<unsigned int, bool> consumeInPieces(uWS::HttpParser &httpParser, std::string request, unsigned int pieceSize, std::string expectedCookie) {
+    unsigned int handled = 0;
+    bool error = false;
+    for (size_t offset = 0; offset < request.length() && !error; offset += pieceSize) {
+        std::string piece = request.substr(offset, pieceSize);
+        piece.append(uWS::MINIMUM_HTTP_POST_PADDING, '\0');
+        void *returned = httpParser.consumePostPadded(piece.data(), (unsigned int) (piece.length() - uWS::MINIMUM_HTTP_POST_PADDING), &handled, nullptr, [&](void *s, uWS::HttpRequest *httpRequest) -> void * {
+            assert(httpRequest->getHeader("host") == "localhost");
+            assert(httpRequest->getHeader("cookie") == expectedCookie);
+            (*(unsigned int *) s)++;
+            return s;
+        }, [](void *user, std::string_view, bool) -> void * {
+            return user;
+        }, [&](void *) -> void * {
+            error = true;
+            return nullptr;
+        });
+        error |= returned != &handled;
+    }
+    return {handled, error};
+}
+
+/* Header blocks spanning reads are buffered until complete, up to UWS_HTTP_MAX_HEADERS_SIZE */
+void testFragmentedHeaders() {
+    std::string request = "GET /fragmented HTTP/1.1\r\nHost: localhost\r\nCookie: a=b\r\n\r\n";
+
+    /* Byte by byte, twice over the same parser (pipelined) */
+    uWS::HttpParser httpParser;
+    assert(consumeInPieces(httpParser, request + request, 1, "a=b") == std::make_pair(2u, false));
+
+    /* Split exactly inside the terminating empty line */
+    for (unsigned int pieceSize = 2; pieceSize < request.length(); pieceSize++) {
+        uWS::HttpParser httpParser;
+        assert(consumeInPieces(httpParser, request, pieceSize, "a=b") == std::make_pair(1u, false));
+    }
+
+    /* Many short lines, each piece resuming where the previous one stopped */
+    std::string manyLines = "GET /many HTTP/1.1\r\nHost: localhost\r\n";
+    for (int i = 0; i < 60; i++) {
+        manyLines += "X-" + std::to_string(i) + ": " + std::to_string(i) + "\r\n";
+    }
+    manyLines += "Cookie: a=b\r\n\r\n";
+    for (unsigned int pieceSize : {1, 3, 7, 64}) {
+        uWS::HttpParser httpParser;
+        assert(consumeInPieces(httpParser, manyLines + request, pieceSize, "a=b") == std::make_pair(2u, false));
+    }
+
+    /* Big cookie headers are accepted only if they fit */
+    for (unsigned int cookieSize : {1000, 3000, 6000, 12000}) {
+        std::string cookie(cookieSize, 'c');
+        std::string request = "GET /big HTTP/1.1\r\nHost: localhost\r\nCookie: " + cookie + "\r\n\r\n";
+        bool fits = request.length() <= UWS_HTTP_MAX_HEADERS_SIZE;
+
+        uWS::HttpParser httpParser;
+        assert(consumeInPieces(httpParser, request, 100, cookie) == std::make_pair(fits ? 1u : 0u, !fits));
+    }
+}
+
+/* Query parameters are decoded once and then looked up or iterated, spilling into the overflow arena if many */
+void testQuery(unsigned int count) {
+    std::string request = "GET /search?empty=&flag&a%20b=c+d&pct=100%2525&eq=x=y&&";
+    for (unsigned int i = 0; i < count; i++) {
+        request += "&p" + std::to_string(i) + "=" + std::to_string(i);
+    }
+    request += "&eq=second HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    request.append(uWS::MINIMUM_HTTP_POST_PADDING, '\0');
+
+    bool handled = false;
+    uWS::HttpParser httpParser;
+    httpParser.consumePostPadded(request.data(), (unsigned int) (request.length() - uWS::MINIMUM_HTTP_POST_PADDING), nullptr, nullptr, [&](void *s, uWS::HttpRequest *httpRequest) -> void * {
+        assert(httpRequest->getUrl() == "/search");
+
+        /* Repeated lookups must not decode twice */
+        for (int i = 0; i < 2; i++) {
+            assert(httpRequest->getQuery("empty") == "" && httpRequest->getQuery("empty").data());
+            assert(httpRequest->getQuery("flag").data() == nullptr);
+            assert(httpRequest->getQuery("a b") == "c d");
+            assert(httpRequest->getQuery("pct") == "100%25");
+            assert(httpRequest->getQuery("eq") == "x=y");
+            assert(httpRequest->getQuery("missing").data() == nullptr);
+            for (unsigned int j = 0; j < count; j++) {
+                assert(httpRequest->getQuery("p" + std::to_string(j)) == std::to_string(j));
+            }
+        }
+
+        std::string pairs;
+        for (auto [key, value] : httpRequest->getQueryParameters()) {
+            pairs += std::string(key) + ":" + std::string(value) + ";";
+        }
+        std::string expected = "empty:;flag:;a b:c d;pct:100%25;eq:x=y;";
+        for (unsigned int i = 0; i < count; i++) {
+            expected += "p" + std::to_string(i) + ":" + std::to_string(i) + ";";
+        }
+        expected += "eq:second;";
+        assert(pairs == expected);
+
+        /* Decoding leaves the request line alone (which still ends with the HTTP version) */
+        std::string rawQuery = "empty=&flag&a%20b=c+d&pct=100%2525&eq=x=y&&";
+        for (unsigned int i = 0; i < count; i++) {
+            rawQuery += "&p" + std::to_string(i) + "=" + std::to_string(i);
+        }
+        rawQuery += "&eq=second";
+        assert(httpRequest->getQuery() == rawQuery + " HTTP/1.1");
+        assert(httpRequest->getFullUrl() == "/search?" + rawQuery + " HTTP/1.1");
+
+        handled = true;
+        return s;
+    }, [](void *user, std::string_view, bool) -> void * {
+        return user;
+    }, [](void *) -> void * {
+        return nullptr;
+    });
+
+    assert(handled);
+}
+
 int main() {
+    testLongHeaders();
+    testQuery(0);
+    testQuery(40);
+    testFragmentedHeaders();
+    testManyHeaders(10, true);
+    testManyHeaders(70, true);
+    /* The request line and the terminating entry take one slot each */
+    testManyHeaders(UWS_HTTP_MAX_HEADERS - 2, true);
+    testManyHeaders(UWS_HTTP_MAX_HEADERS - 1, false);
+
     unsigned char data[] = {0x47, 0x45, 0x54, 0x20, 0x2f, 0x20, 0x48, 0x54, 0x54, 0x50, 0x2f, 0x31, 0x2e, 0x31, 0xd, 0xa, 0x61, 0x73, 0x63, 0x69, 0x69, 0x3a, 0x20, 0x74, 0x65, 0x73, 0x74, 0xd, 0xa, 0x75, 0x74, 0x66, 0x38, 0x3a, 0x20, 0xd1, 0x82, 0xd0, 0xb5, 0xd1, 0x81, 0xd1, 0x82, 0xd, 0xa, 0x48, 0x6f, 0x73, 0x74, 0x3a, 0x20, 0x31, 0x32, 0x37, 0x2e, 0x30, 0x2e, 0x30, 0x2e, 0x31, 0xd, 0xa, 0x43, 0x6f, 0x6e, 0x6e, 0x65, 0x63, 0x74, 0x69, 0x6f, 0x6e, 0x3a, 0x20, 0x63, 0x6c, 0x6f, 0x73, 0x65, 0xd, 0xa, 0xd, 0xa, 'E'};
     int size = sizeof(data) - 1;
     void *user = nullptr;
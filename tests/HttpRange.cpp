@@ -0,0 +1,39 @@
+#include <iostream>
+#include <cassert>
+
+#include "../src/HttpRange.h"
+
+int main() {
+
+    uintmax_t offset = 0, length = 0;
+
+    /* Plain ranges, clamped to the size */
+    assert(uWS::parseRange("bytes=0-99", 1000, offset, length) == uWS::RANGE_PARTIAL && offset == 0 && length == 100);
+    assert(uWS::parseRange("bytes=500-", 1000, offset, length) == uWS::RANGE_PARTIAL && offset == 500 && length == 500);
+    assert(uWS::parseRange("bytes=900-5000", 1000, offset, length) == uWS::RANGE_PARTIAL && offset == 900 && length == 100);
+    assert(uWS::parseRange("Bytes= 0-0 ", 1000, offset, length) == uWS::RANGE_PARTIAL && offset == 0 && length == 1);
+    assert(uWS::parseRange("bytes=0-99999999999999999999999", 1000, offset, length) == uWS::RANGE_PARTIAL && offset == 0 && length == 1000);
+
+    /* Suffixes */
+    assert(uWS::parseRange("bytes=-100", 1000, offset, length) == uWS::RANGE_PARTIAL && offset == 900 && length == 100);
+    assert(uWS::parseRange("bytes=-5000", 1000, offset, length) == uWS::RANGE_PARTIAL && offset == 0 && length == 1000);
+
+    /* Nothing of these exists */
+    assert(uWS::parseRange("bytes=1000-", 1000, offset, length) == uWS::RANGE_UNSATISFIABLE);
+    assert(uWS::parseRange("bytes=99999999999999999999999-", 1000, offset, length) == uWS::RANGE_UNSATISFIABLE);
+    assert(uWS::parseRange("bytes=-0", 1000, offset, length) == uWS::RANGE_UNSATISFIABLE);
+    assert(uWS::parseRange("bytes=-1", 0, offset, length) == uWS::RANGE_UNSATISFIABLE);
+    assert(uWS::parseRange("bytes=0-", 0, offset, length) == uWS::RANGE_UNSATISFIABLE);
+
+    /* Ignored, these get the whole thing */
+    assert(uWS::parseRange("", 1000, offset, length) == uWS::RANGE_NONE);
+    assert(uWS::parseRange("bytes=", 1000, offset, length) == uWS::RANGE_NONE);
+    assert(uWS::parseRange("bytes=-", 1000, offset, length) == uWS::RANGE_NONE);
+    assert(uWS::parseRange("bytes=5-1", 1000, offset, length) == uWS::RANGE_NONE);
+    assert(uWS::parseRange("bytes=0-1,5-6", 1000, offset, length) == uWS::RANGE_NONE);
+    assert(uWS::parseRange("items=0-1", 1000, offset, length) == uWS::RANGE_NONE);
+    assert(uWS::parseRange("bytes=a-b", 1000, offset, length) == uWS::RANGE_NONE);
+
+    std::cout << "ALL DONE" << std::endl;
+    return 0;
+}
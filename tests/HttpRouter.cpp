@@ -2,6 +2,7 @@
 
 #include <cassert>
 #include <iostream>
+#include <thread>
 
 void testMethodPriority() {
     std::cout << "TestMethodPriority" << std::endl;
@@ -376,7 +377,286 @@ void testParameters() {
     assert(result == "GLWGPW");
 }
 
+void testCompiled() {
+    std::cout << "TestCompiled" << std::endl;
+    uWS::HttpRouter<int> r;
+    std::string result;
+
+    /* Enough static siblings to get a jump table, some sharing first byte */
+    const char *names[] = {"alpha", "beta", "gamma", "delta", "apple", "bravo", "golf", "echo", "", "avocado"};
+    for (const char *name : names) {
+        r.add({"GET"}, std::string("/x/") + name, [&result, name](auto *) {
+            result += std::string("[") + name + "]";
+            return true;
+        });
+    }
+
+    r.add({"GET"}, "/x/:param", [&result](auto *h) {
+        result += "P" + std::string(h->getParameters().second[0]);
+        return true;
+    });
+
+    r.compile();
+    for (const char *name : names) {
+        result.clear();
+        assert(r.route("GET", std::string("/x/") + name));
+        assert(result == std::string("[") + name + "]");
+    }
+
+    result.clear();
+    assert(r.route("GET", "/x/avocadoes"));
+    assert(result == "Pavocadoes");
+
+    /* Adding and removing after routing must be reflected */
+    r.add({"GET"}, "/x/avocadoes", [&result](auto *) {
+        result += "S";
+        return true;
+    });
+
+    result.clear();
+    assert(r.route("GET", "/x/avocadoes"));
+    assert(result == "S");
+
+    r.remove("GET", "/x/avocadoes", r.MEDIUM_PRIORITY);
+    r.remove("GET", "/x/:param", r.MEDIUM_PRIORITY);
+
+    result.clear();
+    assert(r.route("GET", "/x/avocadoes") == false);
+    assert(r.route("GET", "/x/golf"));
+    assert(result == "[golf]");
+}
+
+void testCache() {
+    std::cout << "TestCache" << std::endl;
+    uWS::HttpRouter<int> r;
+    std::string result;
+
+    r.setCacheSize(16);
+
+    r.add({"GET"}, "/users/list", [&result](auto *) {
+        result += "S";
+        return false;
+    });
+
+    r.add({"GET"}, "/users/:id", [&result](auto *h) {
+        result += "P" + std::string(h->getParameters().second[0]);
+        return true;
+    });
+
+    r.add({"GET"}, "/files/*", [&result](auto *) {
+        result += "W";
+        return true;
+    });
+
+    /* Binds a parameter so never replayed, but only counted as a miss once */
+    for (int i = 0; i < 2; i++) {
+        result.clear();
+        assert(r.route("GET", "/users/list"));
+        assert(result == "SPlist");
+    }
+    assert(r.getCacheStats() == std::make_pair(0ull, 1ull));
+
+    /* Wildcard without parameters is replayed from cache the second time */
+    for (int i = 0; i < 2; i++) {
+        result.clear();
+        assert(r.route("GET", "/files/index.html"));
+        assert(result == "W");
+    }
+    assert(r.getCacheStats() == std::make_pair(1ull, 2ull));
+
+    /* Changes invalidate the cache */
+    r.add({"GET"}, "/files/index.html", [&result](auto *) {
+        result += "F";
+        return true;
+    });
+
+    for (int i = 0; i < 2; i++) {
+        result.clear();
+        assert(r.route("GET", "/files/index.html"));
+        assert(result == "F");
+    }
+    assert(r.getCacheStats() == std::make_pair(2ull, 3ull));
+
+    /* Unknown methods route to nothing */
+    assert(!r.route("PUT", "/files/index.html"));
+}
+
+void testBulk() {
+    std::cout << "TestBulk" << std::endl;
+    uWS::HttpRouter<int> r;
+    std::string result;
+
+    /* Children added out of matching order */
+    std::vector<uWS::HttpRouter<int>::Route> routes;
+    for (int i = 0; i < 1000; i++) {
+        std::string pattern = "/tenant" + std::to_string(i);
+        routes.push_back({{"GET"}, pattern, [&result, i](auto *) {
+            result += "T" + std::to_string(i);
+            return true;
+        }});
+    }
+    routes.push_back({{"GET"}, std::string("/*"), [&result](auto *) {
+        result += "W";
+        return true;
+    }});
+    routes.push_back({{"GET"}, std::string("/:tenant"), [&result](auto *) {
+        result += "P";
+        return false;
+    }});
+    routes.push_back({{"GET", "POST"}, std::string("/tenant500"), [&result](auto *) {
+        result += "U";
+        return true;
+    }, r.HIGH_PRIORITY});
+    r.add(std::move(routes));
+
+    result.clear();
+    r.route("GET", "/tenant999");
+    assert(result == "T999");
+
+    result.clear();
+    r.route("GET", "/tenant500");
+    assert(result == "U");
+
+    result.clear();
+    r.route("POST", "/tenant500");
+    assert(result == "U");
+
+    result.clear();
+    r.route("GET", "/tenant1000");
+    assert(result == "PW");
+
+    /* Single adds after bulk keep the same order */
+    r.add({"GET"}, std::string("/tenant1000"), [&result](auto *) {
+        result += "N";
+        return true;
+    });
+
+    result.clear();
+    r.route("GET", "/tenant1000");
+    assert(result == "N");
+
+    r.remove("GET", "/tenant999", r.MEDIUM_PRIORITY);
+
+    result.clear();
+    r.route("GET", "/tenant999");
+    assert(result == "PW");
+}
+
+void testShared() {
+    std::cout << "TestShared" << std::endl;
+
+    /* User data is per router, so per thread */
+    std::shared_ptr<const uWS::HttpRouter<std::string>> table;
+    {
+        uWS::HttpRouter<std::string> r;
+        r.add({"GET"}, "/users/:id", [](auto *h) {
+            h->getUserData() += "U" + std::string(h->getParameters().second[0]);
+            return true;
+        });
+        r.add({"GET"}, "/*", [](auto *h) {
+            h->getUserData() += "W";
+            return true;
+        });
+        table = r.share();
+
+        /* The router we shared from routes with the table too */
+        assert(r.route("GET", "/users/1"));
+        assert(r.getUserData() == "U1");
+
+        /* Its own routes are not used until it stops using the table */
+        r.add({"POST"}, "/local", [](auto *h) {
+            h->getUserData() += "L";
+            return true;
+        });
+        assert(!r.route("POST", "/local"));
+        r.use(nullptr);
+        assert(r.route("POST", "/local"));
+        assert(!r.route("GET", "/users/1"));
+    }
+
+    /* Routes bound to their thread are never shared, and keep being routed with */
+    {
+        uWS::HttpRouter<std::string> r;
+        r.add({"GET"}, "/ws", [](auto *h) {
+            h->getUserData() += "S";
+            return true;
+        });
+        r.bindToThread();
+        assert(r.share() == nullptr);
+        assert(r.route("GET", "/ws"));
+        assert(r.getUserData() == "S");
+    }
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([table, t]() {
+            uWS::HttpRouter<std::string> r;
+            r.setCacheSize(16);
+            r.use(table);
+
+            for (int i = 0; i < 1000; i++) {
+                r.getUserData().clear();
+                std::string id = std::to_string(t * 1000 + i);
+                assert(r.route("GET", "/users/" + id));
+                assert(r.getUserData() == "U" + id);
+
+                r.getUserData().clear();
+                assert(r.route("GET", "/static"));
+                assert(r.getUserData() == "W");
+                assert(!r.route("POST", "/static"));
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+}
+
+void testNormalization() {
+    std::cout << "TestNormalization" << std::endl;
+    uWS::HttpRouter<int> r;
+    std::string result;
+
+    r.add({"GET"}, "/users/:name/profile", [&result](auto *h) {
+        result += "P" + std::string(h->getParameters().second[0]);
+        return true;
+    });
+
+    r.add({"GET"}, "/", [&result](auto *) {
+        result += "R";
+        return true;
+    });
+
+    /* Raw URLs are routed as they are by default */
+    result.clear();
+    assert(r.route("GET", "/users/J%C3%B6rg/profile"));
+    assert(result == "PJ%C3%B6rg");
+    assert(!r.route("GET", "/users/./bob//profile"));
+
+    r.setUrlNormalization(true);
+
+    result.clear();
+    assert(r.route("GET", "/users/J%C3%B6rg/profile"));
+    assert(result == "PJ\xC3\xB6rg");
+
+    result.clear();
+    assert(r.route("GET", "//users/./bob//x/../profile"));
+    assert(result == "Pbob");
+
+    /* Encoded dot segments are removed as well, and never leave the root */
+    result.clear();
+    assert(r.route("GET", "/users/%2e%2e/%2E%2E/%2e%2e"));
+    assert(result == "R");
+
+    assert(!r.route("GET", "/users/bob%2/profile"));
+}
+
 int main() {
+    testCompiled();
+    testCache();
+    testBulk();
+    testShared();
+    testNormalization();
     testPatternPriority();
     testMethodPriority();
     testUpgrade();
@@ -0,0 +1,80 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <vector>
+
+#include "../src/Multipart.h"
+
+/* Feeds the body in chunks of the given size and returns what the parser saw, or "error" */
+std::string parse(std::string_view contentType, std::string_view body, size_t chunkSize) {
+    uWS::StreamingMultipartParser parser(contentType);
+    std::string result;
+
+    for (size_t offset = 0; offset < body.length(); offset += chunkSize) {
+        bool ok = parser.consume(body.substr(offset, chunkSize), [&result](std::pair<std::string_view, std::string_view> *headers) {
+            result += "[";
+            for (int i = 0; headers[i].first.length(); i++) {
+                result += std::string(headers[i].first) + "=" + std::string(headers[i].second) + ";";
+            }
+            result += "]";
+        }, [&result](std::string_view data, bool last) {
+            result += std::string(data) + (last ? "|" : "");
+        });
+
+        if (!ok) {
+            return "error";
+        }
+    }
+
+    return parser.isDone() ? result : result + "(cut)";
+}
+
+int main() {
+    std::string contentType = "multipart/form-data; boundary=\"AaB03x\"";
+    std::string body = "preamble\r\n--AaB03x\r\n"
+        "Content-Disposition: form-data; name=\"field\"\r\n\r\n"
+        "value\r\n--AaB03x\r\n"
+        "Content-Disposition: form-data; name=\"file\"; filename=\"a.txt\"\r\nContent-Type: text/plain\r\n\r\n"
+        "line one\r\n--AaB03 not a boundary\r\n\r\n--AaB03\r\n--AaB03x\r\n"
+        "\r\n"
+        "no headers\r\n--AaB03x--\r\nepilogue";
+    std::string expected = "[content-disposition=form-data; name=\"field\";]value|"
+        "[content-disposition=form-data; name=\"file\"; filename=\"a.txt\";content-type=text/plain;]line one\r\n--AaB03 not a boundary\r\n\r\n--AaB03|"
+        "[]no headers|";
+
+    /* Any split of the body gives the same parts, no matter where boundaries are cut */
+    for (size_t chunkSize = 1; chunkSize <= body.length(); chunkSize++) {
+        assert(parse(contentType, body, chunkSize) == expected);
+    }
+
+    /* Boundary at the very beginning */
+    assert(parse("multipart/form-data; boundary=b", "--b\r\n\r\nx\r\n--b--", 3) == "[]x|");
+
+    /* Bodies cut short, or without any parts */
+    assert(parse("multipart/form-data; boundary=b", "--b\r\n\r\nabc", 2) == "[]abc(cut)");
+    assert(parse("multipart/form-data; boundary=b", "no parts at all", 4) == "(cut)");
+
+    /* Malformed */
+    assert(parse("text/plain; boundary=b", "--b--", 5) == "error");
+    assert(parse("multipart/form-data", "--b--", 5) == "error");
+    assert(parse("multipart/form-data; boundary=b", "--bx\r\n\r\n", 8) == "error");
+    assert(parse("multipart/form-data; boundary=b", "--b\r\nbad\rline\r\n\r\n", 8) == "error");
+    assert(parse("multipart/form-data; boundary=b", "--b\r\n" + std::string(5000, 'a'), 100) == "error");
+
+    /* Large data passes through in slices of the chunks without being held */
+    {
+        uWS::StreamingMultipartParser parser("multipart/form-data; boundary=b");
+        std::string chunk(1 << 16, 'x');
+        size_t received = 0;
+        assert(parser.consume("--b\r\n\r\n", [](auto *) {}, [](std::string_view, bool) {}));
+        for (int i = 0; i < 100; i++) {
+            assert(parser.consume(chunk, [](auto *) {}, [&received, &chunk](std::string_view data, bool) {
+                assert(data.data() >= chunk.data() && data.data() + data.length() <= chunk.data() + chunk.length());
+                received += data.length();
+            }));
+        }
+        assert(received == 100 * chunk.length());
+    }
+
+    return 0;
+}
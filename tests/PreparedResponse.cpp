@@ -0,0 +1,38 @@
+#include <iostream>
+#include <cassert>
+
+#include "../src/PreparedResponse.h"
+
+int main() {
+
+    {
+        uWS::PreparedResponse prepared = uWS::PreparedResponse().writeHeader("Content-Type", "text/plain").end("Hello world!");
+        std::string_view data = prepared.data();
+
+        std::string_view head = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nDate: ";
+        assert(data.substr(0, head.length()) == head);
+
+        /* The date is left blank for the sender to fill in */
+        data.remove_prefix(head.length());
+        assert(data.substr(0, uWS::PreparedResponse::DATE_LENGTH) == std::string(uWS::PreparedResponse::DATE_LENGTH, ' '));
+        data.remove_prefix(uWS::PreparedResponse::DATE_LENGTH);
+
+#ifndef UWS_HTTPRESPONSE_NO_WRITEMARK
+        assert(data == "\r\nuWebSockets: 20\r\nContent-Length: 12\r\n\r\nHello world!");
+#else
+        assert(data == "\r\nContent-Length: 12\r\n\r\nHello world!");
+#endif
+        assert(prepared.getBody() == "Hello world!");
+        assert(prepared.getHeaders() == "Content-Type: text/plain\r\n");
+    }
+
+    {
+        uWS::PreparedResponse prepared = uWS::PreparedResponse().writeStatus("204 No Content").end();
+        assert(prepared.data().substr(0, 26) == "HTTP/1.1 204 No Content\r\nD");
+        assert(prepared.data().substr(prepared.data().length() - 23) == "\r\nContent-Length: 0\r\n\r\n");
+        assert(prepared.getBody().empty());
+    }
+
+    std::cout << "ALL DONE" << std::endl;
+    return 0;
+}
@@ -38,5 +38,26 @@ int main() {
         assert(uWS::getDecodedQueryValue("test2", (char *) buf.data()) == "some Value");
     }
 
+    {
+        std::string buf = "a=1&&b%3D=%41%2b+&c&d=%4&e=%4&f%=1&g=%zz&=h&i=j=k&l";
+        std::string pairs;
+        uWS::decodeQuery(buf.data(), buf.data() + buf.length(), buf.data(), [&pairs](std::string_view key, std::string_view value) {
+            pairs += std::string(key) + (value.data() ? "=" + std::string(value) : "") + ";";
+        });
+        assert(pairs == "a=1;b==A+ ;c;d;e;g;i=j=k;l;");
+    }
+
+    {
+        /* Runs longer than any vector width, decoded into another buffer */
+        std::string buf = "key=this+is+a+long+value+spanning+many+vectors%2C+some+even+longer+than+thirty-two+bytes&last";
+        std::string pairs, decoded(buf.length(), '\0'), original = buf;
+        uWS::decodeQuery(buf.data(), buf.data() + buf.length(), decoded.data(), [&pairs](std::string_view key, std::string_view value) {
+            pairs += std::string(key) + (value.data() ? "=" + std::string(value) : "") + ";";
+        });
+        assert(pairs == "key=this is a long value spanning many vectors, some even longer than thirty-two bytes;last;");
+        /* Decoding elsewhere leaves the query alone */
+        assert(buf == original);
+    }
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,199 @@
+#include <iostream>
+#include <cassert>
+#include <fstream>
+#include <map>
+
+#include "../src/StaticFiles.h"
+
+/* Records what the handler does to a response */
+struct FakeResponse {
+    std::string status = "200 OK", headers, body;
+    bool ended = false, preparedEnd = false;
+    int sentFd = -1;
+    uintmax_t sentOffset = 0, sentLength = 0;
+
+    FakeResponse *writeStatus(std::string_view s) {
+        status = s;
+        return this;
+    }
+    FakeResponse *writeHeader(std::string_view key, std::string_view value) {
+        headers += std::string(key) + ": " + std::string(value) + "\r\n";
+        return this;
+    }
+    void end(std::string_view data = {}) {
+        body = data;
+        ended = true;
+    }
+    void end(const uWS::PreparedResponse &prepared) {
+        body = prepared.getBody();
+        ended = preparedEnd = true;
+    }
+    void endWithoutBody() {
+        ended = true;
+    }
+    template <class F>
+    void onAborted(F &&) {}
+    bool sendFile(int fd, uintmax_t offset, uintmax_t length) {
+        sentFd = fd;
+        sentOffset = offset;
+        sentLength = length;
+        ended = true;
+        return true;
+    }
+};
+
+struct FakeRequest {
+    std::string url;
+    std::map<std::string, std::string> headers;
+
+    std::string_view getUrl() {
+        return url;
+    }
+    std::string_view getHeader(std::string_view key) {
+        auto it = headers.find(std::string(key));
+        return it == headers.end() ? std::string_view(nullptr, 0) : std::string_view(it->second);
+    }
+    std::string_view getHeader(uWS::WellKnownHeaders::Id id) {
+        switch (id) {
+            case uWS::WellKnownHeaders::IF_NONE_MATCH: return getHeader("if-none-match");
+            case uWS::WellKnownHeaders::IF_MODIFIED_SINCE: return getHeader("if-modified-since");
+            case uWS::WellKnownHeaders::ACCEPT_ENCODING: return getHeader("accept-encoding");
+            default: return getHeader("range");
+        }
+    }
+};
+
+static FakeResponse serve(uWS::StaticFiles &files, std::string url, std::map<std::string, std::string> headers = {}) {
+    FakeResponse res;
+    FakeRequest req = {url, headers};
+    files(&res, &req);
+    assert(res.ended);
+    return res;
+}
+
+static void writeFile(std::string path, std::string content) {
+    std::ofstream(path, std::ios::binary) << content;
+}
+
+int main() {
+    char root[] = "/tmp/uwsStaticFilesXXXXXX";
+    assert(mkdtemp(root));
+    std::string dir = root;
+    mkdir((dir + "/public").c_str(), 0700);
+    writeFile(dir + "/secret", "secret");
+    writeFile(dir + "/public/index.html", "<h1>index</h1>");
+    writeFile(dir + "/public/a b.css", "body{}");
+    writeFile(dir + "/public/large.bin", std::string(1000, 'x'));
+
+    /* Files up to 100 bytes are held in memory, others are sent from their fd */
+    uWS::StaticFiles files(dir + "/public/", "/static", 2, 100, 3600);
+
+    {
+        FakeResponse res = serve(files, "/static/");
+        assert(res.preparedEnd && res.body == "<h1>index</h1>");
+
+        res = serve(files, "/static/a%20b.css");
+        assert(res.preparedEnd && res.body == "body{}");
+        assert(files.get("/static/a%20b.css")->contentType == "text/css; charset=utf-8");
+
+        res = serve(files, "/static/large.bin");
+        assert(!res.preparedEnd && res.sentFd != -1 && res.sentOffset == 0 && res.sentLength == 1000);
+        assert(res.headers.find("Content-Type: application/octet-stream\r\n") != std::string::npos);
+    }
+
+    {
+        /* Nothing outside of root, nothing missing, nothing outside of prefix */
+        assert(serve(files, "/static/../secret").status == "404 Not Found");
+        assert(serve(files, "/static/%2e%2e/secret").status == "404 Not Found");
+        assert(serve(files, "/static/a%00").status == "404 Not Found");
+        assert(serve(files, "/static/%zz").status == "404 Not Found");
+        assert(serve(files, "/static/missing").status == "404 Not Found");
+        assert(serve(files, "/other/index.html").status == "404 Not Found");
+    }
+
+    {
+        /* Conditional requests */
+        std::shared_ptr<uWS::StaticFile> file = files.get("/static/large.bin");
+        assert(serve(files, "/static/large.bin", {{"if-none-match", "\"nope\", W/" + file->etag}}).status == "304 Not Modified");
+        assert(serve(files, "/static/large.bin", {{"if-none-match", "\"nope\""}}).status == "200 OK");
+        assert(serve(files, "/static/large.bin", {{"if-modified-since", file->lastModified}}).status == "304 Not Modified");
+        assert(serve(files, "/static/large.bin", {{"if-none-match", "\"nope\""}, {"if-modified-since", file->lastModified}}).status == "200 OK");
+    }
+
+    {
+        /* Ranges, from memory and from file */
+        FakeResponse res = serve(files, "/static/index.html", {{"range", "bytes=1-2"}});
+        assert(res.status == "206 Partial Content" && res.body == "h1");
+        assert(res.headers.find("Content-Range: bytes 1-2/14\r\n") != std::string::npos);
+
+        res = serve(files, "/static/large.bin", {{"range", "bytes=-10"}});
+        assert(res.status == "206 Partial Content" && res.sentOffset == 990 && res.sentLength == 10);
+
+        res = serve(files, "/static/large.bin", {{"range", "bytes=2000-"}});
+        assert(res.status == "416 Range Not Satisfiable" && res.sentFd == -1);
+
+        /* A range for another version is ignored */
+        res = serve(files, "/static/large.bin", {{"range", "bytes=0-1"}, {"if-range", "\"old\""}});
+        assert(res.status == "200 OK" && res.sentLength == 1000);
+    }
+
+    {
+        /* Cached files stay as they were until revalidated, evicted ones are loaded anew */
+        std::shared_ptr<uWS::StaticFile> index = files.get("/static/index.html");
+        writeFile(dir + "/public/index.html", "<h1>changed</h1>");
+        assert(files.get("/static/index.html") == index);
+
+        files.get("/static/a%20b.css");
+        files.get("/static/large.bin");
+        assert(files.get("/static/index.html") != index);
+        assert(serve(files, "/static/index.html").body == "<h1>changed</h1>");
+
+        /* Evicted files stay usable by whoever holds them */
+        assert(index->response.getBody() == "<h1>index</h1>");
+    }
+
+    {
+        /* Precompressed siblings, for those who accept them and do not ask for a range */
+        writeFile(dir + "/public/app.js", "original");
+        writeFile(dir + "/public/app.js.gz", "gzipped");
+        writeFile(dir + "/public/app.js.br", "brotli");
+
+        FakeResponse res = serve(files, "/static/app.js");
+        assert(res.body == "original" && res.headers.empty());
+        assert(files.get("/static/app.js")->response.getHeaders().find("Vary: Accept-Encoding\r\n") != std::string::npos);
+
+        res = serve(files, "/static/app.js", {{"accept-encoding", "gzip, deflate"}});
+        assert(res.body == "gzipped");
+        res = serve(files, "/static/app.js", {{"accept-encoding", "gzip, br"}});
+        assert(res.body == "brotli");
+        res = serve(files, "/static/app.js", {{"accept-encoding", "gzip, br;q=0"}});
+        assert(res.body == "gzipped");
+        res = serve(files, "/static/app.js", {{"accept-encoding", "br"}, {"range", "bytes=0-3"}});
+        assert(res.body == "orig" && res.headers.find("Content-Encoding") == std::string::npos);
+
+        /* The content type is that of the original */
+        std::shared_ptr<uWS::StaticFile> file = files.get("/static/app.js");
+        assert(file->brotli->contentType == "text/javascript; charset=utf-8");
+        assert(file->brotli->response.getHeaders().find("Content-Encoding: br\r\n") != std::string::npos);
+
+        /* Validators are those of the representation */
+        res = serve(files, "/static/app.js", {{"accept-encoding", "gzip"}, {"if-none-match", file->gzip->etag}});
+        assert(res.status == "304 Not Modified");
+        res = serve(files, "/static/app.js", {{"if-none-match", file->gzip->etag}});
+        assert(res.status == "200 OK" && res.body == "original");
+    }
+
+    {
+        /* Changes are seen once revalidated */
+        uWS::StaticFiles fresh(dir + "/public", "", 16, 100, 0);
+        assert(serve(fresh, "/a%20b.css").body == "body{}");
+        writeFile(dir + "/public/a b.css", "body{color:red}");
+        assert(serve(fresh, "/a%20b.css").body == "body{color:red}");
+    }
+
+    std::string command = "rm -rf " + dir;
+    assert(!system(command.c_str()));
+
+    std::cout << "ALL DONE" << std::endl;
+    return 0;
+}
@@ -0,0 +1,55 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+
+#include "../src/UrlDecoder.h"
+
+std::string decode(std::string url, bool plusAsSpace) {
+    char *end = uWS::decodeUrl(url.data(), url.data() + url.length(), plusAsSpace);
+    return end ? std::string(url.data(), end) : "<malformed>";
+}
+
+std::string normalize(std::string path) {
+    return std::string(path.data(), uWS::normalizeUrlPath(path.data(), path.data() + path.length()));
+}
+
+int main() {
+
+    assert(decode("", false) == "");
+    assert(decode("/plain/path", false) == "/plain/path");
+    assert(decode("%41%2b+%2F%c3%B6", false) == "A++/\xc3\xb6");
+    assert(decode("%41%2b+%2F%c3%B6", true) == "A+ /\xc3\xb6");
+    assert(decode("%4", false) == "<malformed>");
+    assert(decode("%", false) == "<malformed>");
+    assert(decode("a%zz", false) == "<malformed>");
+    assert(decode("a%4g", false) == "<malformed>");
+
+    /* Runs and escapes spanning many vectors */
+    std::string longRun(100, 'x'), encoded, decoded;
+    for (int i = 0; i < 64; i++) {
+        encoded += longRun.substr(0, (size_t) i) + "%E2%82%AC";
+        decoded += longRun.substr(0, (size_t) i) + "\xE2\x82\xAC";
+    }
+    assert(decode(encoded, false) == decoded);
+
+    assert(normalize("") == "");
+    assert(normalize("/") == "/");
+    assert(normalize("/a/b/c") == "/a/b/c");
+    assert(normalize("//") == "/");
+    assert(normalize("/a//b///c//") == "/a/b/c/");
+    assert(normalize("/a/./b/.") == "/a/b/");
+    assert(normalize("/a/b/../c") == "/a/c");
+    assert(normalize("/a/b/..") == "/a/");
+    assert(normalize("/a/..") == "/");
+    assert(normalize("/../../a") == "/a");
+    assert(normalize("/..") == "/");
+    assert(normalize("/.") == "/");
+    assert(normalize("/.hidden/..dots/.../a.") == "/.hidden/..dots/.../a.");
+    assert(normalize("/a/b/c/./../../g") == "/a/g");
+    assert(normalize("/mid/content=5/../6") == "/mid/6");
+
+    /* Segments spanning many vectors */
+    assert(normalize("/" + longRun + "//" + longRun + "/./" + longRun + "/../" + longRun) == "/" + longRun + "/" + longRun + "/" + longRun);
+
+    return 0;
+}
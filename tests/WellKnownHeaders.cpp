@@ -0,0 +1,48 @@
+#include "../src/WellKnownHeaders.h"
+
+#include <cassert>
+#include <vector>
+#include <string>
+#include <iostream>
+
+/* Headers that are not well-known, but similar to ones that are */
+std::vector<std::string> customHeaders = {
+    "",
+    "h",
+    "hosts",
+    "accept-charset",
+    "content-encoding",
+    "content-md5",
+    "sec-websocket-accept",
+    "sec-websocket-keys",
+    "x-forwarded-host",
+    "x-forwarded-proto",
+    "if-match",
+    "if-range",
+    "if-unmodified-since",
+    "proxy-authorization",
+    "Host",
+    "Content-Length"
+};
+
+int main() {
+
+    /* Every well-known header maps to its own slot */
+    for (unsigned int i = 0; i < uWS::WellKnownHeaders::UNKNOWN; i++) {
+        std::string_view name = uWS::WellKnownHeaders::names[i];
+        if (uWS::WellKnownHeaders::classify(name) != i) {
+            std::cout << name << " collides" << std::endl;
+            std::abort();
+        }
+    }
+
+    /* And nothing else is classified */
+    for (std::string &header : customHeaders) {
+        if (uWS::WellKnownHeaders::classify(header) != uWS::WellKnownHeaders::UNKNOWN) {
+            std::cout << header << " is a false positive" << std::endl;
+            std::abort();
+        }
+    }
+
+    std::cout << "ALL PASS" << std::endl;
+}